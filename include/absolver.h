@@ -0,0 +1,104 @@
+#ifndef ABSOLVER_H
+#define ABSOLVER_H
+
+#include "checkpoint.h"
+#include "common.h"
+#include "heuristic_cache.h"
+#include "perf_counters.h"
+#include "search_limits.h"
+#include "solve.h"
+#include "state.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Public API of the libabsolver library.
+//
+// Embedders fill in a SolveRequest with the two disk rings and get back a
+// SolveResponse with the move list and search statistics; nothing is read
+// from stdin or written to stdout. The AB executable is a client of this API.
+
+/// One instance to solve, plus how to solve it and when to give up.
+struct SolveRequest {
+    std::vector<Disk> large; // ring of n*n+1 large disks (jump lengths), n <= kMaxGroupSize
+    std::vector<Disk> small; // small disks; colours 1..n, each n times, plus one 0 (the blank)
+
+    SolverKind solver = SolverKind::IDAStar;
+    HeuristicKind heuristic = HeuristicKind::HopConflict;
+    unsigned threads = 0; // workers for SolverKind::HDAStar; 0 = one per hardware thread
+
+    std::uint64_t nodeBudget = 0;                    // max expansions; 0 = unlimited
+    std::chrono::milliseconds timeBudget{0};         // wall clock from the call; 0 = unlimited
+    const CancellationToken* cancel = nullptr;       // not owned; may be null
+
+    CheckpointOptions checkpoint; // IDA* and A* only; see checkpoint.h
+    std::string tracePath;        // write a search trace here (see trace.h); empty = no trace
+    bool perfCounters = false;    // fill SolveResponse::perf (see perf_counters.h)
+};
+
+enum class SolveStatus {
+    Solved,         // `moves` / `path` hold a solution, optimal unless from SolverKind::Hierarchical
+    NoSolution,     // the search space was exhausted (or the instance is unsolvable)
+    Cancelled,      // SolveRequest::cancel was triggered
+    BudgetExceeded, // the node or time budget ran out
+    InvalidInput,   // the request was rejected; see SolveResponse::error
+};
+
+/// One move: the blank jumps from ring position `from` to `to`, and the
+/// small disk at `to` slides into `from`. `move` is the operator used.
+struct SolveStep {
+    Move move;
+    std::uint32_t from;
+    std::uint32_t to;
+};
+
+struct SolveResponse {
+    SolveStatus status = SolveStatus::NoSolution;
+    std::vector<SolveStep> moves; // empty unless Solved
+    std::vector<State> path;      // start to goal inclusive (moves.size() + 1 states)
+    SearchStats stats;
+    std::uint64_t elapsedMicros = 0;
+    std::string error;            // set for InvalidInput, or when the trace could not be written
+    PerfProfile perf;             // hardware counters per phase if SolveRequest::perfCounters
+};
+
+/**
+ * Reusable solver. Keeps initialized heuristics for recently seen layouts so
+ * repeated requests on the same `large` ring skip the table precomputation.
+ * `Solve` is safe to call from several threads at once.
+ */
+class ABSolver {
+    HeuristicCache cache;
+
+  public:
+    explicit ABSolver(std::size_t cacheCapacity = 256);
+
+    SolveResponse Solve(const SolveRequest& request);
+
+    /// Solve several requests, one response each in the same order, by
+    /// calling Solve() on each in turn.
+    ///
+    /// With `interleave`, A* requests with the same heuristic and ring size (and
+    /// no trace) run as one interleaved search (InterleavedAStar) instead, which
+    /// overlaps one search's cache misses with the others' work. That is off by
+    /// default: on the instances measured so far the extra working set costs
+    /// more than the overlap gains (6.5 s against 5.2 s one by one). Budgets of
+    /// an interleaved run count from this call, and every response of the run
+    /// reports the run's time.
+    std::vector<SolveResponse> SolveBatch(const std::vector<SolveRequest>& requests, bool interleave = false);
+};
+
+/// One-off solve without a shared cache.
+SolveResponse Solve(const SolveRequest& request);
+
+/// Checks the shape of `request` (ring of n*n+1 with 2 <= n <= kMaxGroupSize, matching sizes,
+/// a single blank). Returns an empty string if it is acceptable.
+std::string ValidateRequest(const SolveRequest& request);
+
+/// "solved", "nosolution", "cancelled", "budget", "invalid".
+const char* ToString(SolveStatus status);
+
+#endif // ABSOLVER_H
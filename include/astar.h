@@ -1,21 +1,103 @@
 #ifndef ASTAR_H
 #define ASTAR_H
 
+#include "checkpoint.h"
 #include "common.h"
+#include "group_size.h"
+#include "move_table.h"
 #include "problem.h"
+#include "search_limits.h"
 #include "state.h"
 #include "heuristic.h"
 #include "node.h"
+#include "trace.h"
+#include <cstddef>
 #include <queue>
+#include <vector>
 
 // A* algorithm interface
+// Templated on the heuristic type and group size like IDAStar (see group_size.h).
+template <typename HeuristicT, int N = kDynamicGroupSize>
 class AStar {
 	Problem problem;
-	Heuristic & heuristic;
+	HeuristicT & heuristic;
+	MoveTable<N> moves;
+	SearchLimits limits;
+	SearchStats searchStats;
+	StopReason stop = StopReason::None;
+	CheckpointOptions checkpoint;
+	TraceRecorder * recorder;
   public:
     std::vector<State> solve(bool debug);
-    AStar(const Problem &problem, Heuristic &h);
+    // With a `recorder`, solve() traces every node it expands (see trace.h).
+    AStar(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(),
+          const CheckpointOptions &checkpoint = CheckpointOptions(), TraceRecorder *recorder = nullptr);
     std::vector<State> solve();
+    // Why the last solve() gave up early (StopReason::None if it did not).
+    StopReason stopReason() const { return stop; }
+    bool stopped() const { return stop != StopReason::None; }
+    // Counters for the last solve().
+    const SearchStats & stats() const { return searchStats; }
+};
+
+// Enhanced partial-expansion A* (EPEA*, Felner et al. 2012). An expansion
+// only builds the children whose f equals the node's current value F, then
+// puts the node back on the open list with the next larger child f as its F
+// (or closes it for good). Children that are never needed before the goal
+// are never built, stored or queued. Under HopHeuristic the f of each child
+// comes from a HopOperatorTable (operator_table.h) and one evaluation of the
+// parent, not one evaluation per child. Under HopConflictHeuristic the table's
+// hop sum is a lower bound, and only children it cannot place above F are
+// evaluated in full. Other heuristics evaluate every child. Either way a
+// child's h is remembered across the node's expansions, so each child is
+// evaluated at most once. Returns optimal solutions like AStar; no
+// checkpoints.
+template <typename HeuristicT, int N = kDynamicGroupSize>
+class EPEAStar {
+	Problem problem;
+	HeuristicT & heuristic;
+	MoveTable<N> moves;
+	SearchLimits limits;
+	SearchStats searchStats;
+	StopReason stop = StopReason::None;
+	TraceRecorder * recorder;
+  public:
+    // With a `recorder`, solve() traces every (partial) expansion (see trace.h).
+    EPEAStar(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(),
+             TraceRecorder *recorder = nullptr);
+    std::vector<State> solve(bool debug);
+    std::vector<State> solve();
+    // Why the last solve() gave up early (StopReason::None if it did not).
+    StopReason stopReason() const { return stop; }
+    bool stopped() const { return stop != StopReason::None; }
+    // Counters for the last solve(); a node put back and expanded again counts again.
+    const SearchStats & stats() const { return searchStats; }
+};
+
+// Several independent A* searches that take turns, one expansion each per
+// round. Every search generates its children and prefetches their closed-set
+// slots before any of them probes, so the cache misses of one search overlap
+// with the work of the others. Each search is a resumable step function rather
+// than a thread: there is no stack to switch and no synchronization. Meant for
+// batches of instances with one group size once closed sets outgrow the cache.
+template <typename HeuristicT, int N = kDynamicGroupSize>
+class InterleavedAStar {
+	std::vector<Problem> problems;
+	std::vector<HeuristicT *> heuristics;
+	std::vector<MoveTable<N>> moves;
+	std::vector<SearchLimits> limits;
+	std::vector<SearchStats> searchStats;
+	std::vector<StopReason> stops;
+  public:
+    // One heuristic and one set of limits per problem; the heuristics are
+    // initialized here and only read while solving.
+    InterleavedAStar(const std::vector<Problem> &problems, const std::vector<HeuristicT *> &heuristics,
+                     const std::vector<SearchLimits> &limits);
+    // One solution per problem, in order; empty where none was found.
+    std::vector<std::vector<State>> solve(bool debug);
+    std::size_t size() const { return problems.size(); }
+    StopReason stopReason(std::size_t i) const { return stops[i]; }
+    const SearchStats & stats(std::size_t i) const { return searchStats[i]; }
 };
 
 #endif // ASTAR_H
@@ -0,0 +1,79 @@
+#ifndef BFHS_H
+#define BFHS_H
+
+#include "group_size.h"
+#include "heuristic.h"
+#include "move_table.h"
+#include "problem.h"
+#include "search_limits.h"
+#include "state.h"
+#include "trace.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Breadth-first heuristic search (Zhou & Hansen, 2006) with divide-and-conquer
+ * path recovery.
+ *
+ * The search goes layer by layer from the start and drops every node with
+ * f = g + h above an upper bound. Only a few of the most recent layers are
+ * kept, to catch duplicates; older layers and all parent pointers are thrown
+ * away. Memory therefore grows with the widest layer, not with everything
+ * explored. The bound starts at h(start) and is raised to the smallest f that
+ * was cut off, as in IDA* ("breadth-first iterative deepening"), so the pass
+ * that reaches a goal reaches it at the optimal depth.
+ *
+ * To get the path without parent pointers, every node deeper than a middle
+ * "relay" layer carries the relay-layer state it descends from. Once the goal
+ * is found, the start-to-relay and relay-to-goal halves are solved the same
+ * way, recursively, with the optimal cost as the bound.
+ *
+ * The move graph is directed, so a state can come back after the layers that
+ * held it were dropped; it is then searched again at a larger depth. That
+ * costs time, never correctness.
+ *
+ * Templated on the heuristic type and group size like IDAStar (see group_size.h).
+ */
+template <typename HeuristicT, int N = kDynamicGroupSize>
+class BreadthFirstHeuristicSearch {
+    Problem problem;
+    HeuristicT &heuristic;
+    MoveTable<N> moves;
+    SearchLimits limits;
+    SearchStats searchStats;
+    StopReason stop = StopReason::None;
+    TraceBuffer trace;
+    std::size_t peakStored = 0; // most layer entries held at once, over the last solve()
+
+    struct LayerResult;
+
+    /// One bounded breadth-first search from `from` (at depth `fromDepth`) to
+    /// `target`, or to any goal if `target` is null, no deeper than `maxDepth`.
+    LayerResult searchLayers(const State &from, int fromDepth, int maxDepth, int bound, const State *target);
+
+    /// `from` to the state `result` reached, start and end inclusive; empty if the limits were hit.
+    std::vector<State> recover(const State &from, int fromDepth, const LayerResult &result, int bound);
+
+    /// An optimal path from `from` (depth `fromDepth`) to `target` (depth `targetDepth`).
+    std::vector<State> findPath(const State &from, int fromDepth, const State &target, int targetDepth, int bound);
+
+  public:
+    /// With a `recorder`, solve() traces the nodes of every layer (see trace.h);
+    /// the last records are written when the solver is destroyed.
+    BreadthFirstHeuristicSearch(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(),
+                                TraceRecorder *recorder = nullptr);
+
+    /// Start to goal inclusive; empty if there is no solution or the limits were hit.
+    /// With `debug`, prints one line per bound and the path recovery work to stdout.
+    std::vector<State> solve(bool debug);
+    std::vector<State> solve();
+
+    // Why the last solve() gave up early (StopReason::None if it did not).
+    StopReason stopReason() const { return stop; }
+    bool stopped() const { return stop != StopReason::None; }
+    // Counters for the last solve(), including path recovery; iterations counts the bounds tried.
+    const SearchStats &stats() const { return searchStats; }
+};
+
+#endif // BFHS_H
@@ -0,0 +1,85 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "problem.h"
+#include "state.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/**
+ * Checkpoints for long IDA* and A* solves.
+ *
+ * A solver with a checkpoint path saves its progress there every `interval`
+ * (and when it stops on a limit); a solver created with `resume` set picks up
+ * from that file, if it exists, and finishes with the same solution and
+ * counters as an uninterrupted run. A checkpoint only resumes the instance,
+ * solver and heuristic that wrote it.
+ *
+ * IDA* rewrites one small file: threshold, counters and the DFS stack as child
+ * indices. A* appends the nodes, g updates and closings made since the last
+ * checkpoint to `path`, and rewrites `path`.open with its open list.
+ */
+struct CheckpointOptions {
+    std::string path; // empty = no checkpoints
+    std::chrono::milliseconds interval{std::chrono::seconds(60)};
+    bool resume = false; // continue from `path` if it exists
+
+    bool enabled() const { return !path.empty(); }
+};
+
+/// Raw values, in host byte order: checkpoints are resumed where they were written.
+class CheckpointWriter {
+    std::ofstream out;
+
+  public:
+    CheckpointWriter(const std::string& path, bool append);
+
+    template <typename T>
+    void Put(const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    /// Bit-packed (see PackedState); read back with CheckpointReader::GetState.
+    void PutState(const State& s, unsigned bitsPerDisk);
+    /// Magic tag plus the fingerprint of what wrote the file.
+    void PutHeader(const char (&magic)[9], std::uint64_t fingerprint);
+
+    /// Flushes; false if anything failed to write.
+    bool Finish();
+    std::uint64_t Position() { return static_cast<std::uint64_t>(out.tellp()); }
+};
+
+class CheckpointReader {
+    std::ifstream in;
+
+  public:
+    explicit CheckpointReader(const std::string& path);
+
+    bool IsOpen() const { return in.is_open(); }
+
+    template <typename T>
+    bool Get(T& value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+    bool GetState(State& s, std::size_t ringSize, unsigned bitsPerDisk);
+    /// Throws std::runtime_error if the file is not a `magic` checkpoint of `fingerprint`.
+    void ExpectHeader(const char (&magic)[9], std::uint64_t fingerprint, const std::string& path);
+
+    std::uint64_t Position() { return static_cast<std::uint64_t>(in.tellg()); }
+};
+
+/// Identifies an instance together with the solver and heuristic searching it.
+std::uint64_t CheckpointFingerprint(const Problem& p, const char* solver, const char* heuristic);
+
+/// Moves `tmpPath` over `path` in one step, so a crash leaves the old file or the new one.
+bool ReplaceCheckpointFile(const std::string& tmpPath, const std::string& path);
+
+/// Cuts `path` back to its first `size` bytes.
+bool TruncateCheckpointFile(const std::string& path, std::uint64_t size);
+
+/// Reports a checkpoint that could not be written; the solve itself goes on.
+void WarnCheckpointFailed(const std::string& path);
+
+#endif // CHECKPOINT_H
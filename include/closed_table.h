@@ -0,0 +1,54 @@
+#ifndef CLOSED_TABLE_H
+#define CLOSED_TABLE_H
+
+#include "node.h"
+#include "state.h"
+#include "util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Closed set for A*: open-addressing map from a state to the node holding it.
+ *
+ * Slots keep the full 64-bit hash next to the node pointer, so a probe reads
+ * the slot array and only dereferences a node whose hash matches. Hashing is
+ * separate from probing: a caller with several keys hashes them all, calls
+ * Prefetch() for each, and probes afterwards, so the slot misses overlap
+ * instead of being paid one after another.
+ *
+ * This replaced the PackedState keys A* used before. Those copied every state
+ * a second time next to its node; a slot here is a hash and a pointer, and a
+ * hash match is confirmed against the node's own State.
+ */
+class ClosedTable {
+    struct Slot {
+        std::uint64_t hash;
+        Node* node; // nullptr = empty
+    };
+
+    std::vector<Slot> slots;
+    std::size_t mask = 0;
+    std::size_t count = 0;
+
+    void Grow();
+
+  public:
+    explicit ClosedTable(std::size_t expected = 1024);
+
+    static std::uint64_t HashOf(const State& s);
+
+    /// Start loading the slot `hash` probes first. No effect on the contents.
+    void Prefetch(std::uint64_t hash) const { PrefetchForRead(&slots[hash & mask]); }
+
+    /// The node stored for `s` (whose HashOf is `hash`), or nullptr.
+    Node* Find(const State& s, std::uint64_t hash) const;
+
+    /// Store `node` under its state, replacing the node of an equal state.
+    void Insert(Node* node, std::uint64_t hash);
+
+    std::size_t Size() const { return count; }
+};
+
+#endif // CLOSED_TABLE_H
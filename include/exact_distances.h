@@ -0,0 +1,24 @@
+#ifndef EXACT_DISTANCES_H
+#define EXACT_DISTANCES_H
+
+#include "problem.h"
+#include "state.h"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/// Exact number of moves to the nearest goal rotation, for every state that can
+/// reach one. Computed by breadth-first search backwards from all goal rotations
+/// of `p.large`, so it is only practical for small rings (n <= 3).
+std::unordered_map<State, int, StateHash> ComputeExactDistances(const Problem& p);
+
+/// Same search, stopped after the layer at `maxDepth` or before starting a new
+/// layer once `maxStates` states are known (0 = no cap). Every layer in the
+/// result is complete, so the distances are exact up to the largest one.
+std::unordered_map<State, int, StateHash> ComputeExactDistances(const Problem& p, int maxDepth, std::size_t maxStates);
+
+/// The goal state whose blank sits at `zeroIndex` for group size `n`.
+State MakeGoalState(std::uint32_t zeroIndex, int n);
+
+#endif // EXACT_DISTANCES_H
@@ -0,0 +1,55 @@
+#ifndef FRINGE_SEARCH_H
+#define FRINGE_SEARCH_H
+
+#include "group_size.h"
+#include "heuristic.h"
+#include "move_table.h"
+#include "problem.h"
+#include "search_limits.h"
+#include "state.h"
+#include "trace.h"
+
+#include <vector>
+
+/**
+ * Fringe Search (Björnsson et al., 2005).
+ *
+ * Same threshold passes as IDA*, but the frontier is kept between passes:
+ * one list holds the nodes still to visit in this pass ("now") followed by
+ * the nodes that exceeded the threshold ("later"), and a cache keyed by state
+ * remembers g, h and the parent of every node generated. Each pass resumes
+ * from the previous frontier instead of the root, visits nodes in IDA*'s
+ * left-to-right order (children go right after their parent) and never
+ * re-evaluates the heuristic for a cached state.
+ *
+ * Memory grows with the number of distinct states generated, like A*.
+ * Templated on the heuristic type and group size like IDAStar (see group_size.h).
+ */
+template <typename HeuristicT, int N = kDynamicGroupSize>
+class FringeSearch {
+    Problem problem;
+    HeuristicT &heuristic;
+    MoveTable<N> moves;
+    SearchLimits limits;
+    SearchStats searchStats;
+    StopReason stop = StopReason::None;
+    TraceRecorder *recorder;
+
+  public:
+    /// With a `recorder`, solve() traces every node it visits (see trace.h).
+    FringeSearch(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(),
+                 TraceRecorder *recorder = nullptr);
+
+    /// Start to goal inclusive; empty if there is no solution or the limits were hit.
+    /// With `debug`, prints one line per threshold pass to stdout.
+    std::vector<State> solve(bool debug);
+    std::vector<State> solve();
+
+    // Why the last solve() gave up early (StopReason::None if it did not).
+    StopReason stopReason() const { return stop; }
+    bool stopped() const { return stop != StopReason::None; }
+    // Counters for the last solve(), summed over all threshold passes.
+    const SearchStats &stats() const { return searchStats; }
+};
+
+#endif // FRINGE_SEARCH_H
@@ -0,0 +1,98 @@
+#ifndef GROUP_SIZE_H
+#define GROUP_SIZE_H
+
+#include "common.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compile-time specialization on the group size `n`.
+//
+// The solvers and heuristics are templates over an `int N`. For the common
+// group sizes (kMinStaticGroupSize..kMaxStaticGroupSize) N is the group size
+// itself, so the ring size and every per-ring loop bound are constants.
+// N == kDynamicGroupSize is the generic fallback that reads sizes at runtime.
+
+constexpr int kDynamicGroupSize = 0;
+constexpr int kMinStaticGroupSize = 2;
+constexpr int kMaxStaticGroupSize = 6;
+
+/// Largest group size accepted end to end (a ring of 1025 positions).
+constexpr int kMaxGroupSize = 32;
+
+/// Number of ring positions for group size `n` (n*n discs plus the blank).
+constexpr std::uint32_t RingSize(int n) { return static_cast<std::uint32_t>(n * n + 1); }
+
+/// Group size for a ring of `ringSize` positions: floor(sqrt(ringSize)),
+/// the same way the CLI derives it from the input length.
+inline int GroupSizeForRing(std::size_t ringSize) {
+    int n = 0;
+    while (static_cast<std::size_t>(n + 1) * static_cast<std::size_t>(n + 1) <= ringSize) ++n;
+    return n;
+}
+
+/// Tag type carrying a group size as a compile-time constant.
+template <int N>
+struct GroupSize {
+    static constexpr int value = N;
+};
+
+/// Per-ring storage and sizes for a fixed group size.
+template <int N>
+struct Ring {
+    static constexpr std::uint32_t kSize = RingSize(N);
+
+    template <typename T>
+    using Array = std::array<T, kSize>;
+
+    static std::uint32_t Size(const std::vector<Disk>&) { return kSize; }
+    static int Group(int) { return N; }
+
+    template <typename T>
+    static void Resize(Array<T>&, std::uint32_t) {}
+};
+
+/// Generic fallback: sizes come from the data.
+template <>
+struct Ring<kDynamicGroupSize> {
+    template <typename T>
+    using Array = std::vector<T>;
+
+    static std::uint32_t Size(const std::vector<Disk>& v) { return static_cast<std::uint32_t>(v.size()); }
+    static int Group(int n) { return n; }
+
+    template <typename T>
+    static void Resize(Array<T>& a, std::uint32_t size) { a.resize(size); }
+};
+
+/// Calls `fn(GroupSize<N>{})` with the static N matching `n`, or with
+/// GroupSize<kDynamicGroupSize> if there is no specialization for it (or the
+/// ring does not have the n*n + 1 positions the specializations assume).
+template <typename Fn>
+auto DispatchGroupSize(int n, std::size_t ringSize, Fn&& fn) -> decltype(fn(GroupSize<kDynamicGroupSize>{})) {
+    if (ringSize == RingSize(n)) {
+        switch (n) {
+            case 2: return fn(GroupSize<2>{});
+            case 3: return fn(GroupSize<3>{});
+            case 4: return fn(GroupSize<4>{});
+            case 5: return fn(GroupSize<5>{});
+            case 6: return fn(GroupSize<6>{});
+            default: break;
+        }
+    }
+    return fn(GroupSize<kDynamicGroupSize>{});
+}
+
+/// Explicitly instantiates `Template<Arg, N>` for every supported N.
+/// Used by the .cpp files that define the solver templates.
+#define AB_INSTANTIATE_FOR_GROUP_SIZES(Template, Arg)  \
+    template class Template<Arg, kDynamicGroupSize>;   \
+    template class Template<Arg, 2>;                   \
+    template class Template<Arg, 3>;                   \
+    template class Template<Arg, 4>;                   \
+    template class Template<Arg, 5>;                   \
+    template class Template<Arg, 6>;
+
+#endif // GROUP_SIZE_H
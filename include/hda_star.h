@@ -0,0 +1,60 @@
+#ifndef HDA_STAR_H
+#define HDA_STAR_H
+
+#include "group_size.h"
+#include "heuristic.h"
+#include "move_table.h"
+#include "problem.h"
+#include "search_limits.h"
+#include "state.h"
+#include "trace.h"
+
+#include <vector>
+
+/**
+ * Hash-distributed parallel A* (HDA*).
+ *
+ * Each worker thread owns the states whose packed hash maps to it and keeps
+ * its own open list and closed table for them. Generated children go to
+ * their owner in batches through lock-free queues (mpsc_queue.h), so no data
+ * structure is shared between workers except the inboxes and a few counters.
+ *
+ * Workers expand in local f order, so the first goal found need not be
+ * optimal: it only sets an upper bound U, and nodes with f >= U are pruned.
+ * The search ends when every worker is idle and no message is in flight
+ * (one shared counter of active workers plus queued messages reaching zero);
+ * at that point nothing with f < U is left, so U is optimal.
+ *
+ * Templated on the heuristic type and group size like AStar (see group_size.h).
+ * The heuristic is evaluated concurrently and must be read-only after initialize().
+ */
+template <typename HeuristicT, int N = kDynamicGroupSize>
+class HDAStar {
+    Problem problem;
+    HeuristicT &heuristic;
+    MoveTable<N> moves;
+    SearchLimits limits;
+    unsigned threads;
+    SearchStats searchStats;
+    StopReason stop = StopReason::None;
+    TraceRecorder *recorder;
+
+  public:
+    /// `threads` = 0 uses one worker per hardware thread. With a `recorder`,
+    /// each worker traces the nodes it handles under its own thread id (see trace.h).
+    HDAStar(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(), unsigned threads = 0,
+            TraceRecorder *recorder = nullptr);
+
+    /// Start to goal inclusive; empty if there is no solution or the limits were hit.
+    /// With `debug`, prints per-worker counters to stdout.
+    std::vector<State> solve(bool debug);
+    std::vector<State> solve();
+
+    // Why the last solve() gave up early (StopReason::None if it did not).
+    StopReason stopReason() const { return stop; }
+    bool stopped() const { return stop != StopReason::None; }
+    // Counters for the last solve(), summed over the workers.
+    const SearchStats &stats() const { return searchStats; }
+};
+
+#endif // HDA_STAR_H
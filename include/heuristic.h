@@ -1,31 +1,97 @@
 #ifndef HEURISTIC_H
 #define HEURISTIC_H
 
+#include "group_size.h"
+#include "hop_table.h"
+#include "move_table.h"
 #include "state.h"
 #include "problem.h"
 
 // Heuristic interface
+//
+// initialize() is a no-op when the heuristic is already set up for the same
+// layout, so one initialized heuristic can be cached and shared read-only
+// between solvers (each solver constructor calls initialize()).
 struct Heuristic {
     virtual int operator()(const State &s) const = 0;
     virtual void initialize(const Problem& p) {}
     virtual ~Heuristic() = default;
+
+    // Static dispatch hook for the solver templates (see group_size.h).
+    // Concrete heuristics hide this with a version specialized on N; through
+    // the base type it falls back to the virtual call.
+    template <int N>
+    int Evaluate(const State &s) const { return (*this)(s); }
 };
 
 struct ZeroHeuristic : Heuristic {
     int operator()(const State&) const override { return 0; }
+
+    template <int N>
+    int Evaluate(const State&) const { return 0; }
 };
 
 struct MisplacedDiscHeuristic: Heuristic {
+    int groupSize = 0;
+
     int operator()(const State&) const override;
+    void initialize(const Problem& p) override;
+
+    template <int N>
+    int Evaluate(const State&) const;
 };
 
 struct HopHeuristic : Heuristic {
-    std::vector<std::vector<int>> hopMatrix;
+    // Hops for a disc to reach a slot, or the nearest slot of a colour's goal
+    // segment. Exact for small rings, lower bounds for large ones (hop_table.h).
+    // Summing one segment row per disc gives h for every goal rotation at once.
+    HopTable hops;
+    int groupSize = 0;
+
+    // The `Problem::large` layout the tables were built for.
+    std::vector<Disk> layout;
+
+    int operator()(const State&) const override;
+    void initialize(const Problem& p) override;
+    bool IsInitializedFor(const Problem& p) const { return groupSize == p.n && layout == p.large; }
+
+    template <int N>
+    int Evaluate(const State&) const;
+
+    // h of each goal rotation (indexed by the goal blank's position); Evaluate
+    // is their minimum. A move changes each entry by the difference of two
+    // segment rows, which EPEA* reads from a HopOperatorTable.
+    template <int N>
+    void EvaluateRotations(const State&, typename Ring<N>::template Array<int>& rotationH) const;
+};
+
+// HopHeuristic plus admissible penalties for what the independent hop sum
+// ignores (see heuristic.cpp):
+//  - discs of one colour competing for the same goal slots (min-cost assignment
+//    of discs to slots instead of each disc's nearest slot),
+//  - blank travel: moves before the blank can pull any disc closer to its goal,
+//  - the blank's own distance to the goal rotation's blank position.
+struct HopConflictHeuristic : HopHeuristic {
+    MoveTable<kDynamicGroupSize> blankMoves;
 
     int operator()(const State&) const override;
     void initialize(const Problem& p) override;
+
+    template <int N>
+    int Evaluate(const State&) const;
+
+  private:
+    int BlankTravelPenalty(const State& s, uint32_t rotation) const;
 };
 
+// Every heuristic type the solver templates are instantiated for.
+#define AB_FOR_EACH_HEURISTIC(X) \
+    X(Heuristic)                 \
+    X(ZeroHeuristic)             \
+    X(MisplacedDiscHeuristic)    \
+    X(HopHeuristic)              \
+    X(HopConflictHeuristic)
+
 uint32_t MisplacedDiscCount(const State& s, uint32_t startIdx, uint32_t n);
 
 #endif // HEURISTIC_H
@@ -0,0 +1,40 @@
+#ifndef HEURISTIC_CACHE_H
+#define HEURISTIC_CACHE_H
+
+#include "heuristic.h"
+#include "problem.h"
+#include "solve.h"
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * Initialized heuristics keyed by heuristic kind and `Problem::large` layout.
+ *
+ * An entry is built once (by whichever thread asks first) and then only read,
+ * so concurrent solves can share it. Oldest entries are evicted first; callers
+ * still holding an evicted entry keep it alive until they let go.
+ */
+class HeuristicCache {
+    struct Entry {
+        std::once_flag once;
+        std::unique_ptr<Heuristic> heuristic;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<Entry>> entries;
+    std::deque<std::string> insertionOrder;
+    std::size_t capacity;
+
+  public:
+    explicit HeuristicCache(std::size_t capacity);
+
+    /// The heuristic of `kind`, initialized for `p`'s layout.
+    std::shared_ptr<Heuristic> Get(HeuristicKind kind, const Problem& p);
+};
+
+#endif // HEURISTIC_CACHE_H
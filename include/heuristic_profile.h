@@ -0,0 +1,81 @@
+#ifndef HEURISTIC_PROFILE_H
+#define HEURISTIC_PROFILE_H
+
+#include "problem.h"
+#include "solve.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Heuristic accuracy profiling and IDA* node-count prediction for one
+// `Problem::large` layout (`AB --profile`).
+//
+// Accuracy: a bounded backward BFS from every goal rotation gives states at
+// known exact distances; each heuristic is compared with them depth by depth.
+//
+// Prediction (Korf, Reid & Edelkamp 2001): IDA* with threshold T expands
+//   E(T) = sum_{i=0..T} N_i * P(T - i)
+// nodes, where N_i is the number of depth-i nodes in the brute-force search
+// tree and P_i(v) the fraction of them with h <= v. N_i is counted exactly
+// from the blank's move graph (without immediate reversals, which IDA*'s path
+// check always prunes). P_i is measured on random walks from the start, the
+// nodes IDA* actually meets: uniformly random states have h far above
+// anything near the start and predict almost no nodes. A walk picks each
+// move with equal probability, so its depth-i node is weighted by the product
+// of the branching factors on the way, which makes the sample uniform over
+// the tree's depth-i nodes.
+
+struct ProfileOptions {
+    int maxDepth = 14;                 // deepest BFS layer to profile
+    std::size_t maxStates = 1000000;   // stop the BFS before a layer once this many states are known
+    std::size_t samples = 5000;        // random walks from the start for P_i(v) and the evaluation cost
+    int thresholds = 12;               // thresholds to predict (>= 1), starting at h(start) (or 1)
+    std::uint32_t seed = 355;
+};
+
+/// Accuracy and cost of one heuristic on one layout.
+struct HeuristicProfile {
+    HeuristicKind kind;
+
+    struct Depth {
+        int depth;
+        std::uint64_t states = 0;
+        std::uint64_t exact = 0;         // h == depth
+        std::uint64_t overestimates = 0; // h > depth (inadmissible)
+        int minH = 0;
+        int maxH = 0;
+        double meanH = 0;
+        std::vector<std::uint64_t> histogram; // histogram[h] = states with that h
+    };
+    std::vector<Depth> depths; // index = depth
+
+    // P_i(v) = hAtMost[i][min(v, size - 1)] over depth-i nodes of the brute-force tree
+    std::vector<std::vector<double>> hAtMost;
+    double nanosPerEvaluation = 0; // on the random-walk states
+    int startH = 0;              // h(p.smallState)
+};
+
+/// N_i for i = 0..maxDepth: depth-i nodes of the brute-force tree from `start`.
+std::vector<double> BruteForceTreeSizes(const Problem& p, const State& start, int maxDepth);
+
+/// Profile `kind` against states grouped by exact distance (statesByDepth[d]
+/// holds states d moves from the nearest goal) and against random walks from
+/// `p.smallState`, as deep as the last of `options.thresholds` thresholds.
+HeuristicProfile ProfileHeuristic(const Problem& p,
+                                  HeuristicKind kind,
+                                  const std::vector<std::vector<State>>& statesByDepth,
+                                  const ProfileOptions& options);
+
+/// KRE estimate of the nodes one IDA* pass with `threshold` expands; at least
+/// 1 (the start is always expanded).
+double PredictIdaNodes(const std::vector<double>& treeSizes,
+                       const std::vector<std::vector<double>>& hAtMost,
+                       int threshold);
+
+/// Profile every heuristic on `p.large` and print the report to `out`.
+/// `p.smallState` is used as the start for the predictions.
+void RunHeuristicProfile(const Problem& p, const ProfileOptions& options, std::ostream& out);
+
+#endif // HEURISTIC_PROFILE_H
@@ -0,0 +1,92 @@
+#ifndef HIERARCHICAL_H
+#define HIERARCHICAL_H
+
+#include "group_size.h"
+#include "heuristic.h"
+#include "move_table.h"
+#include "problem.h"
+#include "search_limits.h"
+#include "state.h"
+#include "trace.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fast suboptimal solver for rings too large for the optimal engines.
+ *
+ * Blank walks (+-1 moves) never change the cyclic order of the discs, only
+ * jumps do (see solvability.h). The solver builds the goal order as a run of
+ * discs, 1..1 2..2 ... n..n, one disc at a time. It starts from the longest
+ * stretch that already reads like some part of the goal; each step then
+ * brings a disc of the next colour right behind the run, or into the run's
+ * unfinished colour block. A step is a small weighted A* over (run start,
+ * disc, blank) triples, guided by the disc's distance to the run around it.
+ * The blank may walk through the run, which slides it along the ring without
+ * breaking it, and jump over discs of one colour block, but no jump may take
+ * a disc out of the run or drop a stranger in. Other discs are pushed around
+ * freely, so the triple is all a step has to track. Once the run holds every
+ * disc, the blank walks out of it and the ring is solved. A few starting
+ * stretches are tried and the shortest path is kept.
+ *
+ * The concatenated steps then go through a shortening pass: repeated states
+ * are cut out, and a shallow search from every state on the path looks for a
+ * later state it reaches in fewer moves than the path takes.
+ *
+ * Solutions are valid but not optimal; the optimal solvers give the shortest
+ * ones. The heuristic only supplies the lower bound shown with `debug` and
+ * the h of traced states. Needs a ring of n*n + 1 positions.
+ * Templated on the heuristic type and group size like IDAStar (see group_size.h).
+ */
+template <typename HeuristicT, int N = kDynamicGroupSize>
+class HierarchicalSolver {
+    Problem problem;
+    HeuristicT &heuristic;
+    MoveTable<N> moves;
+    SearchLimits limits;
+    SearchStats searchStats;
+    StopReason stop = StopReason::None;
+    TraceBuffer trace;
+
+    std::vector<std::uint16_t> blankHops;    // [from * ring + to]: the blank's fewest moves between positions
+    std::vector<std::uint32_t> landingStart; // jumps landing on position p: landingFrom[landingStart[p]..landingStart[p + 1])
+    std::vector<std::uint32_t> landingFrom;  // blank positions whose jump lands there
+    std::uint32_t longestSkip = 1;           // most discs one jump moves a disc past
+    std::vector<std::uint64_t> zobrist;      // [position * (n + 1) + disc]
+
+    /// Lay the run out from the disc at `runStart` to the whole ring, appending
+    /// the blank positions visited to `blanks`. That disc takes index `phase`
+    /// of the goal order, and the first `runLength` discs already match it.
+    /// False if it gave up.
+    bool buildRun(std::uint32_t runStart, std::uint32_t phase, std::uint32_t runLength, State &state,
+                  std::vector<std::uint32_t> &blanks);
+
+    /// Bring a disc of the next colour right behind the run; updates `runStart`.
+    bool extendRun(std::uint32_t &runStart, std::uint32_t phase, std::uint32_t runLength, State &state,
+                   std::vector<std::uint32_t> &blanks);
+
+    /// Shorten the path from `start` along `blanks`; returns the moves saved.
+    std::size_t shorten(const State &start, std::vector<std::uint32_t> &blanks);
+
+    std::uint64_t hashOf(const State &s) const;
+
+  public:
+    /// With a `recorder`, solve() traces the state after every disc added to the run (see trace.h).
+    HierarchicalSolver(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(),
+                       TraceRecorder *recorder = nullptr);
+
+    /// Start to goal inclusive; empty if there is no solution, the ring is not
+    /// n*n + 1 positions long, or the limits were hit.
+    /// With `debug`, prints one line per run start tried to stdout.
+    std::vector<State> solve(bool debug);
+    std::vector<State> solve();
+
+    // Why the last solve() gave up early (StopReason::None if it did not).
+    StopReason stopReason() const { return stop; }
+    bool stopped() const { return stop != StopReason::None; }
+    // Counters for the last solve(): expanded counts the nodes of the run steps,
+    // iterations the run starts tried.
+    const SearchStats &stats() const { return searchStats; }
+};
+
+#endif // HIERARCHICAL_H
@@ -0,0 +1,60 @@
+#ifndef HOP_TABLE_H
+#define HOP_TABLE_H
+
+#include "problem.h"
+
+#include <cstdint>
+#include <vector>
+
+/// Largest group size whose hop distances are stored exactly (ring x ring).
+/// Larger rings store per-block lower bounds instead (see HopTable).
+constexpr int kMaxExactHopGroupSize = 16;
+
+/**
+ * Disc travel distances for one `Problem::large` layout.
+ *
+ * A disc only moves into the blank, so a disc needs as many hops to get from
+ * a to b as the blank needs to get from b to a.
+ *
+ * Up to kMaxExactHopGroupSize the table is exact: one entry per (disc
+ * position, slot) and one per (disc position, goal segment start), both
+ * ring x ring. Above that, slots are grouped into blocks of n consecutive
+ * positions and only the distance to the nearest slot of each block is kept
+ * (ring x (n + 1) entries, one multi-source BFS per block). Every lookup then
+ * returns a lower bound on the true distance that still changes by at most
+ * one per move, so heuristics built on it stay admissible.
+ */
+class HopTable {
+  public:
+    using Hops = std::uint16_t;
+
+    void Build(const Problem& p);
+
+    /// True if lookups return exact distances rather than block lower bounds.
+    bool IsExact() const { return blockSize == 1; }
+
+    /// Hops for a disc at `from` to reach `slot` (a lower bound if !IsExact()).
+    int DiscToSlot(std::uint32_t from, std::uint32_t slot) const {
+        const std::uint32_t column = blockSize == 1 ? slot : slot / blockSize;
+        return slotHops[static_cast<std::size_t>(from) * columns + column];
+    }
+
+    /// Hops for a disc at `from` to reach the nearest of the n slots starting
+    /// at `start`, for every `start` at once. The row is 2 * ring entries long
+    /// (start and start + ring hold the same value) so callers can read any
+    /// ring-long window of it without wrapping. Points into the table when
+    /// exact; otherwise fills `scratch` (2 * ring entries) and returns it.
+    const Hops* SegmentRow(std::uint32_t from, Hops* scratch) const;
+
+    std::uint32_t RingSize() const { return ring; }
+
+  private:
+    std::uint32_t ring = 0;
+    std::uint32_t group = 0;
+    std::uint32_t blockSize = 1;
+    std::uint32_t columns = 0;      // ring when exact, number of blocks otherwise
+    std::vector<Hops> slotHops;     // [from * columns + slot / blockSize]
+    std::vector<Hops> segmentHops;  // [from * 2 * ring + start]; exact tables only
+};
+
+#endif // HOP_TABLE_H
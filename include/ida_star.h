@@ -1,10 +1,15 @@
 #ifndef IDA_STAR_H
 #define IDA_STAR_H
 
+#include "checkpoint.h"
 #include "common.h"
+#include "group_size.h"
+#include "move_table.h"
 #include "problem.h"
+#include "search_limits.h"
 #include "state.h"
 #include "heuristic.h"
+#include "trace.h"
 
 #include <cstdint>
 #include <vector>
@@ -27,10 +32,22 @@
  *      - If goal found: return the path
  *      - Otherwise: set threshold to the minimum f-cost that exceeded the
  *        previous threshold, and repeat
+ *
+ * The solver is a template over the heuristic type (calls are resolved
+ * statically instead of through `Heuristic&`) and over the group size N (see
+ * group_size.h). Instantiated in ida_star.cpp for every heuristic in
+ * AB_FOR_EACH_HEURISTIC and every supported N.
  */
+template <typename HeuristicT, int N = kDynamicGroupSize>
 class IDAStar {
   Problem problem;
-  Heuristic &heuristic;
+  HeuristicT &heuristic;
+  MoveTable<N> moves;
+  SearchLimits limits;
+  SearchStats searchStats;
+  StopReason stop = StopReason::None;
+  CheckpointOptions checkpoint;
+  TraceBuffer trace;
 
   // Stats collected across a single bounded DFS iteration (one threshold pass).
   struct IterationStats {
@@ -38,12 +55,39 @@ class IDAStar {
     uint64_t pruned = 0;   // number of nodes cut off because f > threshold
   };
 
+  // Where the search is, as far as a checkpoint needs to know.
+  struct Progress {
+    int threshold = 0;
+    uint32_t iteration = 0;
+    uint64_t totalExpanded = 0; // over finished iterations (debug summary)
+    uint64_t totalPruned = 0;
+    IterationStats current;
+  };
+
+  // One per DFS level, mirroring the recursion: the child being explored and
+  // the smallest f above the threshold seen so far at that level.
+  struct Frame {
+    uint32_t child;
+    int minExcess;
+  };
+
+  Progress progress;
+  std::vector<Frame> frames;
+  // After a resume, DFS levels [0, replayDepth) are re-entered from `frames`
+  // instead of being evaluated again.
+  std::size_t replayDepth = 0;
+  SearchLimits::Clock::time_point nextCheckpoint;
+
 public:
   /**
    * Construct an IDA* solver for a problem instance and heuristic.
    * The heuristic is initialized with the problem (same as A* does).
+   * The search gives up once `limits` are exceeded (see stopReason()).
+   * With a `recorder`, every node visited goes to its trace (see trace.h);
+   * the last records are written when the solver is destroyed.
    */
-  IDAStar(const Problem &problem, Heuristic &h);
+  IDAStar(const Problem &problem, HeuristicT &h, const SearchLimits &limits = SearchLimits(),
+          const CheckpointOptions &checkpoint = CheckpointOptions(), TraceRecorder *recorder = nullptr);
 
   /**
    * Solve the problem.
@@ -70,6 +114,13 @@ public:
   /// Convenience overload: run without debug output.
   std::vector<State> solve();
 
+  /// Why the last solve() gave up early (StopReason::None if it did not).
+  StopReason stopReason() const { return stop; }
+  bool stopped() const { return stop != StopReason::None; }
+
+  /// Counters for the last solve(), summed over all threshold passes.
+  const SearchStats &stats() const { return searchStats; }
+
 private:
   /**
    * Depth-first search bounded by `threshold`.
@@ -90,6 +141,7 @@ private:
    *
    * @returns
    *  - If goal found: returns -1 (a sentinel indicating success)
+   *  - If the search limits were exceeded: returns -2
    *  - Otherwise: returns the minimum f-cost that exceeded `threshold` encountered
    *    in this subtree (used as the next threshold).
    */
@@ -106,6 +158,12 @@ private:
    * Used to prevent trivial cycles without storing a global closed set.
    */
   bool isOnPath(const State &s, const std::vector<State> &path) const;
+
+  /// Save `progress`, the counters and frames[0..depth] (see checkpoint.h).
+  void writeCheckpoint(std::size_t depth);
+
+  /// Restore what writeCheckpoint saved. False if there is no checkpoint file.
+  bool readCheckpoint();
 };
 
 #endif // IDA_STAR_H
@@ -0,0 +1,55 @@
+#ifndef MOVE_TABLE_H
+#define MOVE_TABLE_H
+
+#include "common.h"
+#include "group_size.h"
+#include "problem.h"
+#include "util.h"
+
+#include <cstdint>
+
+/// Destinations of the blank from one ring position, in expansion order:
+/// SWAP_RIGHT, SWAP_LEFT, then SWAP_N_RIGHT, SWAP_N_LEFT if the large disk != 1.
+struct BlankMoves {
+    std::uint32_t to[4];
+    std::uint32_t count;
+};
+
+/// Precomputed move generator for a `Problem::large` layout.
+/// Shared by the solvers so child generation is a table lookup and a swap.
+template <int N>
+class MoveTable {
+    typename Ring<N>::template Array<BlankMoves> moves;
+
+  public:
+    MoveTable() = default;
+
+    explicit MoveTable(const Problem& p) {
+        const std::uint32_t ring = Ring<N>::Size(p.large);
+        Ring<N>::Resize(moves, ring);
+
+        const int total = static_cast<int>(ring);
+        for (std::uint32_t i = 0; i < ring; ++i) {
+            const int pos = static_cast<int>(i);
+            const int largeValue = static_cast<int>(p.large[i]);
+
+            BlankMoves& m = moves[i];
+            m.to[0] = static_cast<std::uint32_t>(WrapIndex(pos + largeValue, total));
+            m.to[1] = static_cast<std::uint32_t>(WrapIndex(pos - largeValue, total));
+            m.to[2] = static_cast<std::uint32_t>(WrapIndex(pos + 1, total));
+            m.to[3] = static_cast<std::uint32_t>(WrapIndex(pos - 1, total));
+            m.count = largeValue != 1 ? 4 : 2;
+        }
+    }
+
+    const BlankMoves& operator[](std::uint32_t pos) const { return moves[pos]; }
+};
+
+/// Apply a blank move: the disc at `to` slides into the blank at `s.zeroIndex`.
+inline void ApplyBlankMove(State& s, std::uint32_t to) {
+    s.small[s.zeroIndex] = s.small[to];
+    s.small[to] = 0;
+    s.zeroIndex = to;
+}
+
+#endif // MOVE_TABLE_H
@@ -0,0 +1,74 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Lock-free multi-producer, single-consumer queue of batches.
+ *
+ * Producers push whole batches (one allocation and one CAS per batch); the
+ * consumer takes everything queued so far with a single exchange. Items of
+ * one batch stay in order; batches come out oldest first.
+ */
+template <typename T>
+class MpscBatchQueue {
+    struct Batch {
+        std::vector<T> items;
+        Batch* next;
+    };
+
+    std::atomic<Batch*> head{nullptr};
+
+  public:
+    MpscBatchQueue() = default;
+    MpscBatchQueue(const MpscBatchQueue&) = delete;
+    MpscBatchQueue& operator=(const MpscBatchQueue&) = delete;
+
+    ~MpscBatchQueue() {
+        Batch* b = head.load(std::memory_order_acquire);
+        while (b != nullptr) {
+            Batch* next = b->next;
+            delete b;
+            b = next;
+        }
+    }
+
+    /// Any thread. `items` is moved from.
+    void Push(std::vector<T>&& items) {
+        Batch* b = new Batch{std::move(items), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// Any thread; only a hint unless called by the consumer.
+    bool Empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+
+    /// Consumer only. Appends every queued batch to `out`; returns the number of items.
+    std::size_t PopAll(std::vector<std::vector<T>>& out) {
+        Batch* b = head.exchange(nullptr, std::memory_order_acquire);
+
+        // The stack is newest first; reverse it.
+        Batch* oldest = nullptr;
+        while (b != nullptr) {
+            Batch* next = b->next;
+            b->next = oldest;
+            oldest = b;
+            b = next;
+        }
+
+        std::size_t count = 0;
+        while (oldest != nullptr) {
+            Batch* next = oldest->next;
+            count += oldest->items.size();
+            out.push_back(std::move(oldest->items));
+            delete oldest;
+            oldest = next;
+        }
+        return count;
+    }
+};
+
+#endif // MPSC_QUEUE_H
@@ -3,7 +3,11 @@
 
 #include "state.h"
 
-// Search node (state, cost, parent)
+#include <cstdint>
+
+// Search node (state, cost, parent). Holds the full State (one byte per disc):
+// A* memory per node does not shrink with PackedState, which only the HDA*,
+// Fringe Search and BFHS tables use.
 struct Node {
   State state;
   int g; // Cost so far
@@ -11,6 +15,7 @@ struct Node {
   int f() const { return g + h; }
 
   Node * parent;
+  std::uint64_t id = 0; // index in the solver's node store
 };
 
 #endif // NODE_H
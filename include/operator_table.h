@@ -0,0 +1,43 @@
+#ifndef OPERATOR_TABLE_H
+#define OPERATOR_TABLE_H
+
+#include "heuristic.h"
+#include "problem.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Operator table for enhanced partial expansion (EPEA*, see astar.h) under
+ * HopHeuristic.
+ *
+ * A blank move from b to b' slides the disc at b' one hop, into b. Its term in
+ * the h of every goal rotation changes from the disc's segment row read at b'
+ * to the row read at b, at the disc's colour offset plus the rotation. The
+ * table stores that difference for every (blank position, move) over a whole
+ * 2 * ring segment row, so the window for any colour and rotation needs no
+ * wrap. Given a node's per-rotation h (HopHeuristic::EvaluateRotations), the
+ * exact h of a child is then one pass over the rotations, and the children
+ * of a node can be sorted by f before any of them is built.
+ */
+class HopOperatorTable {
+  public:
+    using Delta = std::int16_t;
+
+    void Build(const Problem& p, const HopHeuristic& h);
+
+    /// Change in h, per goal rotation, when the blank at `blank` takes its
+    /// move number `move` (see BlankMoves) and the disc it moves has colour
+    /// `colour`: ring entries, indexed by the goal blank's position.
+    const Delta* Deltas(std::uint32_t blank, std::uint32_t move, Disk colour) const {
+        const std::size_t row = (static_cast<std::size_t>(blank) * 4 + move) * 2 * ring;
+        return &deltas[row + 1 + static_cast<std::size_t>(colour - 1) * group];
+    }
+
+  private:
+    std::uint32_t ring = 0;
+    std::uint32_t group = 0;
+    std::vector<Delta> deltas; // [((blank * 4 + move) * 2 * ring) + segment offset + rotation]
+};
+
+#endif // OPERATOR_TABLE_H
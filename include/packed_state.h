@@ -0,0 +1,49 @@
+#ifndef PACKED_STATE_H
+#define PACKED_STATE_H
+
+#include "state.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// Bits needed per small disk for group size `n` (colours 0..n).
+unsigned BitsPerDisk(int n);
+
+/**
+ * Compact copy of a State for hash tables that hold many states.
+ *
+ * Each small disk takes BitsPerDisk(n) = ceil(log2(n + 1)) bits instead of a
+ * byte, packed into 64-bit words without straddling a word. Only the words
+ * are stored, so keys compare equal only between states packed for the same
+ * n; each table holds states of a single group size.
+ */
+class PackedState {
+    std::vector<std::uint64_t> words;
+
+  public:
+    PackedState() = default;
+    PackedState(const State& s, unsigned bitsPerDisk);
+    /// Rebuild from Words() of an earlier PackedState.
+    explicit PackedState(std::vector<std::uint64_t> packedWords) : words(std::move(packedWords)) {}
+
+    /// The state this was packed from; `ringSize` is its number of positions.
+    State Unpack(std::size_t ringSize, unsigned bitsPerDisk) const;
+
+    bool operator==(const PackedState& other) const { return words == other.words; }
+    std::size_t Hash() const;
+
+    /// Number of words a state of `ringSize` discs packs into.
+    static std::size_t WordCount(std::size_t ringSize, unsigned bitsPerDisk) {
+        const std::size_t perWord = 64 / bitsPerDisk;
+        return (ringSize + perWord - 1) / perWord;
+    }
+    const std::vector<std::uint64_t>& Words() const { return words; }
+};
+
+struct PackedStateHash {
+    std::size_t operator()(const PackedState& s) const { return s.Hash(); }
+};
+
+#endif // PACKED_STATE_H
@@ -0,0 +1,118 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "search_limits.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Hardware performance counters per solver phase (Linux perf_event_open).
+ *
+ * A PerfSession opens one counter group for its thread (cycles, instructions,
+ * cache misses, branch misses; user space only) and the phases below add what
+ * they used to its profile. Solve() opens one for SolveRequest::perfCounters. The report gives IPC and misses
+ * per expanded node, which tells a solve that waits on the hash tables apart
+ * from one that computes heuristics.
+ *
+ * Counters may be missing: other kernels and platforms, a container without
+ * the syscall, perf_event_paranoid, or a PMU without one of the events. The
+ * solve then runs as usual and the report says what was unavailable. Without
+ * a profile a phase only tests a thread-local pointer.
+ *
+ * Counters are per thread, so HDA* workers are not counted.
+ */
+
+enum class PerfPhase {
+    HeuristicInit, // HopHeuristic::initialize: hop tables
+    IDAPass,       // one IDA* threshold iteration
+    AStarExpand,   // A*: pop, generate and evaluate children (sampled)
+    AStarProbe,    // A*: closed-set probes and inserts, open-list pushes (sampled)
+};
+constexpr int kPerfPhaseCount = 4;
+
+/// A* measures one expansion in this many; the counter reads would cost more than a node.
+constexpr std::uint64_t kPerfSampleInterval = 16;
+
+struct PerfCounts {
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t cacheMisses = 0;
+    std::uint64_t branchMisses = 0;
+    std::uint64_t scopes = 0; // measurements added
+    std::uint64_t nodes = 0;  // expanded nodes they covered
+
+    void Add(const PerfCounts& other);
+};
+
+/// Counter totals of one solve.
+struct PerfProfile {
+    bool available = false;
+    std::string unavailable;       // why counters (or some events) are missing; empty if all opened
+    bool hasCycles = false, hasInstructions = false, hasCacheMisses = false, hasBranchMisses = false;
+    PerfCounts phases[kPerfPhaseCount];
+    std::vector<PerfCounts> passes; // one per IDA* threshold iteration, in order
+
+    PerfCounts& operator[](PerfPhase phase) { return phases[static_cast<int>(phase)]; }
+    const PerfCounts& operator[](PerfPhase phase) const { return phases[static_cast<int>(phase)]; }
+};
+
+/// "heuristic-init", "ida-pass", "astar-expand", "astar-probe".
+const char* ToString(PerfPhase phase);
+
+/// "[perf] ..." lines: per phase cycles, IPC and misses per node, one line
+/// per IDA* pass, and `stats` for the solve as a whole.
+void WritePerfReport(std::ostream& out, const PerfProfile& profile, const SearchStats& stats);
+
+/// Counts for the calling thread into `profile` (if not null) while alive.
+/// Opens the counters on construction and closes them on destruction.
+class PerfSession {
+    PerfSession* outer;
+    PerfProfile* profile;
+    int fds[4] = {-1, -1, -1, -1}; // leader (cycles) first; -1 where an event did not open
+    int slots[4] = {-1, -1, -1, -1}; // index of each event in a group read
+
+  public:
+    explicit PerfSession(PerfProfile* profile);
+    ~PerfSession();
+    PerfSession(const PerfSession&) = delete;
+    PerfSession& operator=(const PerfSession&) = delete;
+
+    /// The calling thread's innermost session with counters, or null.
+    static PerfSession* Current();
+
+    /// Current counter values (scaled if the group was multiplexed).
+    bool Read(PerfCounts& out) const;
+
+    PerfProfile& Profile() { return *profile; }
+};
+
+/// Adds the counts between construction and Stop() (or destruction) to
+/// `phase` of the current session's profile; does nothing without one, or
+/// when `measure` is false.
+class PerfScope {
+    PerfSession* session;
+    PerfPhase phase;
+    PerfCounts start;
+
+    void Begin();
+    void Finish(std::uint64_t nodes);
+
+  public:
+    explicit PerfScope(PerfPhase phase, bool measure = true)
+        : session(measure ? PerfSession::Current() : nullptr), phase(phase) {
+        if (session != nullptr) Begin();
+    }
+    ~PerfScope() { Stop(0); }
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    /// End the measurement; `nodes` is the number of expanded nodes it covered.
+    void Stop(std::uint64_t nodes) {
+        if (session != nullptr) Finish(nodes);
+    }
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,73 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "absolver.h"
+#include "search_limits.h"
+#include "solve.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Solver portfolio: race several solver/heuristic pairs on one instance.
+//
+// Which engine and heuristic are fastest varies a lot between instances, and
+// every pair here is optimal, so the first one to finish has the answer. Each
+// entry runs on its own thread; the first conclusive result (solved or proven
+// unsolvable) cancels the rest. Records of which entry won each instance tune
+// the default lineup (see AppendPortfolioRecord / SummarizePortfolioRecords).
+
+/// One racer.
+struct PortfolioEntry {
+    SolverKind solver;
+    HeuristicKind heuristic;
+};
+
+/// Fringe Search and IDA* with HopConflict, A* with Hop.
+std::vector<PortfolioEntry> DefaultPortfolio();
+
+/// Parse a comma-separated list of <solver>:<heuristic>, e.g.
+/// "fringe:hop-conflict,astar:hop", or "default". False on unknown names
+/// and on "hier", which is not optimal.
+bool ParsePortfolio(const std::string& spec, std::vector<PortfolioEntry>& out);
+
+/// "<solver>:<heuristic>", as ParsePortfolio reads it.
+std::string ToString(const PortfolioEntry& entry);
+
+/// How one entry's run ended.
+struct PortfolioOutcome {
+    PortfolioEntry entry;
+    SolveStatus status;    // Cancelled for the entries that lost the race
+    std::uint64_t elapsedMicros; // from the start of the race until this entry stopped
+    SearchStats stats;
+};
+
+struct PortfolioResponse {
+    /// The winner's response. If nobody finished, BudgetExceeded or Cancelled
+    /// from the request's own limits; every pair is optimal or silent, so there
+    /// is no partial answer to fall back on.
+    SolveResponse response;
+    int winner = -1; // index into the entries; -1 if none finished
+    std::vector<PortfolioOutcome> outcomes; // one per entry, in entry order
+};
+
+/**
+ * Race `entries` on `request` (its `solver` and `heuristic` are ignored). The
+ * request's budgets and cancel token bound the whole race; checkpoints and
+ * traces are not written. Heuristic tables come from `solver`'s cache. Returns once every
+ * entry has stopped.
+ */
+PortfolioResponse SolvePortfolio(ABSolver& solver, const SolveRequest& request,
+                                 const std::vector<PortfolioEntry>& entries);
+
+/// One line describing who won `request`, for SummarizePortfolioRecords:
+///   instance=<hex> ring=<r> winner=<entry>|none moves=<k> time_us=<t> <entry>=<status>:<time_us> ...
+void AppendPortfolioRecord(std::ostream& out, const SolveRequest& request, const PortfolioResponse& result);
+
+/// Reads AppendPortfolioRecord lines and prints, per entry, how many races it
+/// won and its mean winning time, most wins first.
+void SummarizePortfolioRecords(std::istream& in, std::ostream& out);
+
+#endif // PORTFOLIO_H
@@ -0,0 +1,70 @@
+#ifndef SEARCH_LIMITS_H
+#define SEARCH_LIMITS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Limits and counters shared by the solvers.
+
+/// Lets another thread ask a running solve to stop. A token with a parent
+/// also reports cancelled once the parent is, so a group of solves can be
+/// stopped together without losing the caller's own token.
+class CancellationToken {
+    std::atomic<bool> cancelled{false};
+    const CancellationToken* parent; // not owned; may be null
+
+  public:
+    explicit CancellationToken(const CancellationToken* parentToken = nullptr) : parent(parentToken) {}
+
+    void Cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const {
+        return cancelled.load(std::memory_order_relaxed) || (parent != nullptr && parent->IsCancelled());
+    }
+};
+
+/// Why a solver gave up before finishing.
+enum class StopReason {
+    None,       // ran to completion (solved or exhausted)
+    Deadline,   // wall-clock budget exceeded
+    NodeBudget, // expansion budget exceeded
+    Cancelled,  // CancellationToken::Cancel() was called
+};
+
+/// Solvers only look at the clock and the token once per this many expansions.
+constexpr std::uint64_t kLimitCheckInterval = 1024;
+
+/// Bounds on a single solve. A solver that hits one stops and returns no
+/// solution; `stopReason()` on the solver tells that apart from "no solution".
+struct SearchLimits {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point deadline = Clock::time_point::max();
+    std::uint64_t maxExpansions = 0;           // 0 = unlimited
+    const CancellationToken* cancel = nullptr; // not owned; may be null
+
+    /// Limits with a wall-clock budget starting now.
+    static SearchLimits WithTimeBudget(std::chrono::milliseconds budget) {
+        SearchLimits limits;
+        limits.deadline = Clock::now() + budget;
+        return limits;
+    }
+
+    /// Called by the solvers once per expansion with the running total.
+    StopReason Check(std::uint64_t expanded) const {
+        if (maxExpansions != 0 && expanded > maxExpansions) return StopReason::NodeBudget;
+        if (expanded % kLimitCheckInterval != 0) return StopReason::None;
+        if (cancel != nullptr && cancel->IsCancelled()) return StopReason::Cancelled;
+        if (deadline != Clock::time_point::max() && Clock::now() >= deadline) return StopReason::Deadline;
+        return StopReason::None;
+    }
+};
+
+/// Work done by one solve, summed over all iterations.
+struct SearchStats {
+    std::uint64_t expanded = 0;   // nodes whose successors were generated
+    std::uint64_t generated = 0;  // successor states created
+    std::uint32_t iterations = 0; // IDA* threshold passes (1 for A*)
+};
+
+#endif // SEARCH_LIMITS_H
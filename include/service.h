@@ -0,0 +1,43 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Long-running solver service (`AB --serve`).
+ *
+ * Reads one request per line and answers each with one line, solving
+ * concurrently on a worker pool. Per-layout precomputation (heuristic tables)
+ * is cached across requests, so repeated layouts skip initialization.
+ *
+ * Request:
+ *   <id> <ring> <large x ring> <small x ring> [solver=ida|astar|hda|fringe|bfhs|epea|hier]
+ *        [heuristic=zero|misplaced|hop|hop-conflict] [time_ms=<budget>]
+ *        [threads=<hda workers>] [portfolio=default|<solver>:<heuristic>,...]
+ *        [trace=1]
+ *
+ * With `portfolio`, the listed pairs race on their own threads (see
+ * portfolio.h) and the response names the winner after time_us. With
+ * `trace=1`, the solve is traced to <trace dir>/<id>.abtrace (see trace.h);
+ * it is an error unless the service was started with a trace directory.
+ *
+ * Response (one line, in completion order; match on <id>):
+ *   <id> solved moves=<k> time_us=<t> [winner=<pair>] path=<state>;<state>;...
+ *   <id> nosolution time_us=<t> [winner=<pair>]
+ *   <id> timeout time_us=<t>
+ *   <id> error <message>
+ * where each <state> is the small disks, comma-separated.
+ */
+struct ServiceOptions {
+    std::string socketPath; // Unix domain socket to listen on; empty = stdin/stdout
+    std::size_t workers = 0; // 0 = one per hardware thread
+    std::size_t cacheCapacity = 256; // cached (heuristic, layout) pairs
+    std::string traceDir; // where trace=1 requests write their traces; empty = refuse them
+};
+
+/// Run the service until stdin closes (stdin mode) or forever (socket mode).
+/// Returns a process exit code.
+int RunService(const ServiceOptions& options);
+
+#endif // SERVICE_H
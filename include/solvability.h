@@ -0,0 +1,36 @@
+#ifndef SOLVABILITY_H
+#define SOLVABILITY_H
+
+#include "problem.h"
+
+/// Outcome of the up-front solvability analysis.
+enum class Solvability {
+    Unsolvable, // no goal rotation can be reached; solvers return immediately
+    Solvable,   // some goal rotation is reachable
+    Unknown,    // the instance is outside what the analysis covers
+};
+
+/**
+ * Classify an instance before searching, in time linear in the ring size.
+ *
+ * Every position has a +-1 move, so the position graph (the one behind
+ * HopHeuristic's hop matrix) is strongly connected and never rules a disc out
+ * on its own. What can is the cyclic order of the discs around the ring:
+ *  - +-1 moves never change it; they only walk the blank between two discs.
+ *  - A jump of effective length e >= 2 (large value mod ring, either way round)
+ *    moves one disc past e - 1 others. Two such jumps at neighbouring offsets
+ *    compose to a 3-cycle, and those 3-cycles generate every even
+ *    rearrangement. Each colour appears at least twice, so parity is free too
+ *    and every arrangement with the right colour counts is reachable.
+ *  - With only effective jumps of 0 or 1, the cyclic order is invariant and
+ *    the instance is solvable iff it already matches the goal's.
+ *
+ * Wrong colour counts or blanks are unsolvable. Rings that are not n*n + 1
+ * positions long are reported as Unknown.
+ */
+Solvability AnalyzeSolvability(const Problem& p);
+
+/// Printable name of a classification (for debug output).
+const char* ToString(Solvability s);
+
+#endif // SOLVABILITY_H
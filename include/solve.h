@@ -0,0 +1,158 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include "astar.h"
+#include "bfhs.h"
+#include "checkpoint.h"
+#include "fringe_search.h"
+#include "group_size.h"
+#include "hda_star.h"
+#include "heuristic.h"
+#include "hierarchical.h"
+#include "ida_star.h"
+#include "problem.h"
+#include "search_limits.h"
+#include "state.h"
+#include "trace.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Solver and heuristic selection, shared by the CLI and the service mode.
+
+enum class SolverKind {
+    IDAStar,
+    AStar,
+    HDAStar, // hash-distributed parallel A*
+    Fringe,  // Fringe Search: IDA* passes resumed from the previous frontier
+    BFHS,    // breadth-first heuristic search: layer memory only, divide-and-conquer path
+    EPEAStar, // enhanced partial-expansion A*: builds only the children with the node's current f;
+              // child h from an operator table under hop, bounded by it under hop-conflict
+    Hierarchical, // not optimal: places one colour block at a time, then shortens the path
+};
+
+enum class HeuristicKind {
+    Zero,
+    MisplacedDisc,
+    Hop,
+    HopConflict,
+};
+
+struct SolveOptions {
+    SolverKind solver = SolverKind::IDAStar;
+    bool debug = false; // pass through to solver (debug printing)
+    SearchLimits limits;
+    unsigned threads = 0; // HDA* workers; 0 = one per hardware thread
+    CheckpointOptions checkpoint; // IDA* and A* only
+    TraceRecorder* trace = nullptr; // not owned; null = no trace (see trace.h)
+};
+
+struct SolveResult {
+    std::vector<State> solution;                // start to goal inclusive; empty if none found
+    StopReason stopReason = StopReason::None;   // why the search gave up on `SolveOptions::limits`
+    SearchStats stats;
+
+    bool stopped() const { return stopReason != StopReason::None; }
+};
+
+template <typename SolverT>
+SolveResult RunSolver(SolverT& solver, const SolveOptions& opts) {
+    SolveResult result;
+    result.solution = solver.solve(opts.debug);
+    result.stopReason = solver.stopReason();
+    result.stats = solver.stats();
+    return result;
+}
+
+// Keep solver selection logic in one place.
+// The group size is resolved once here: common sizes run a solver specialized
+// for that N, anything else runs the generic (kDynamicGroupSize) instantiation.
+template <typename HeuristicT>
+SolveResult SolveProblem(const Problem& p, HeuristicT& heuristic, const SolveOptions& opts) {
+    return DispatchGroupSize(p.n, p.large.size(), [&](auto groupSize) {
+        constexpr int N = decltype(groupSize)::value;
+        switch (opts.solver) {
+            case SolverKind::AStar: {
+                AStar<HeuristicT, N> solver(p, heuristic, opts.limits, opts.checkpoint, opts.trace);
+                return RunSolver(solver, opts);
+            }
+            case SolverKind::HDAStar: {
+                HDAStar<HeuristicT, N> solver(p, heuristic, opts.limits, opts.threads, opts.trace);
+                return RunSolver(solver, opts);
+            }
+            case SolverKind::Fringe: {
+                FringeSearch<HeuristicT, N> solver(p, heuristic, opts.limits, opts.trace);
+                return RunSolver(solver, opts);
+            }
+            case SolverKind::BFHS: {
+                BreadthFirstHeuristicSearch<HeuristicT, N> solver(p, heuristic, opts.limits, opts.trace);
+                return RunSolver(solver, opts);
+            }
+            case SolverKind::EPEAStar: {
+                EPEAStar<HeuristicT, N> solver(p, heuristic, opts.limits, opts.trace);
+                return RunSolver(solver, opts);
+            }
+            case SolverKind::Hierarchical: {
+                HierarchicalSolver<HeuristicT, N> solver(p, heuristic, opts.limits, opts.trace);
+                return RunSolver(solver, opts);
+            }
+            case SolverKind::IDAStar:
+                break;
+        }
+        IDAStar<HeuristicT, N> solver(p, heuristic, opts.limits, opts.checkpoint, opts.trace);
+        return RunSolver(solver, opts);
+    });
+}
+
+/// Solve several instances with interleaved A* (see InterleavedAStar), one
+/// result per problem. All problems must share a group size; `heuristics[i]`
+/// and `limits[i]` belong to problem i.
+template <typename HeuristicT>
+std::vector<SolveResult> SolveInterleaved(const std::vector<Problem>& problems,
+                                          const std::vector<HeuristicT*>& heuristics,
+                                          const std::vector<SearchLimits>& limits,
+                                          bool debug = false) {
+    if (problems.empty()) return {};
+    return DispatchGroupSize(problems[0].n, problems[0].large.size(), [&](auto groupSize) {
+        constexpr int N = decltype(groupSize)::value;
+        InterleavedAStar<HeuristicT, N> solver(problems, heuristics, limits);
+        std::vector<std::vector<State>> solutions = solver.solve(debug);
+
+        std::vector<SolveResult> results(problems.size());
+        for (std::size_t i = 0; i < problems.size(); ++i) {
+            results[i].solution = std::move(solutions[i]);
+            results[i].stopReason = solver.stopReason(i);
+            results[i].stats = solver.stats(i);
+        }
+        return results;
+    });
+}
+
+/// SolveInterleaved with heuristics of the runtime type `kind` (see SolveProblem below).
+std::vector<SolveResult> SolveInterleaved(const std::vector<Problem>& problems,
+                                          const std::vector<Heuristic*>& heuristics,
+                                          HeuristicKind kind,
+                                          const std::vector<SearchLimits>& limits,
+                                          bool debug = false);
+
+/// Solve with a heuristic chosen at runtime. `heuristic` must be the type
+/// `kind` names (e.g. from MakeHeuristic); it is used through its concrete type.
+SolveResult SolveProblem(const Problem& p, Heuristic& heuristic, HeuristicKind kind, const SolveOptions& opts);
+
+/// A new, uninitialized heuristic of the given kind.
+std::unique_ptr<Heuristic> MakeHeuristic(HeuristicKind kind);
+
+/// Parse "ida" / "astar" / "hda" / "fringe" / "bfhs" / "epea" / "hier". Returns false for unknown names.
+bool ParseSolverKind(const std::string& name, SolverKind& out);
+
+/// The name ParseSolverKind accepts for `kind`.
+const char* ToString(SolverKind kind);
+
+/// Parse "zero" / "misplaced" / "hop" / "hop-conflict". Returns false for unknown names.
+bool ParseHeuristicKind(const std::string& name, HeuristicKind& out);
+
+/// The name ParseHeuristicKind accepts for `kind`.
+const char* ToString(HeuristicKind kind);
+
+#endif // SOLVE_H
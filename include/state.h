@@ -19,6 +19,12 @@ struct State {
   /// Returns true if this state is a goal state for the given group size `n`.
   bool IsGoal(int n) const;
 
+  /// Compile-time variant of `IsGoal`. For a static group size N the ring size
+  /// and goal layout are constants and `n` is ignored; N == kDynamicGroupSize
+  /// forwards to `IsGoal(n)`. Instantiated in state.cpp for the sizes in group_size.h.
+  template <int N>
+  bool IsGoal(int n) const;
+
   /// Finds the index of the empty space (0) in `small`.
   /// Precondition: `small` contains exactly one 0.
   std::uint32_t GetZeroIndex() const;
@@ -0,0 +1,139 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "group_size.h"
+#include "state.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+/**
+ * Binary search traces for offline analysis.
+ *
+ * A solver given a TraceRecorder logs one TraceRecord per node it looks at:
+ * expanded, pruned by the bound, dropped as a duplicate, reopened, or the goal,
+ * plus one Bound record per threshold pass. Each search thread fills its own
+ * TraceBuffer and hands full buffers to the recorder, which appends them to
+ * the file as chunks; threads never share a buffer.
+ *
+ * Tracing is off unless a recorder is passed in. A solver without one only
+ * tests a null pointer per node, and nothing is hashed or copied.
+ *
+ * File layout (host byte order, like checkpoints):
+ *   "ABTRACE2", uint32 ring size, uint32 label length, label bytes
+ *   chunks of: uint32 thread, uint32 count, count x TraceRecord
+ * AB --trace-report <file> summarizes a trace (see SummarizeTrace).
+ */
+
+enum class TraceEvent : std::uint8_t {
+    Expanded,  // successors generated
+    Pruned,    // f above the bound (IDA*, Fringe) or not below the best cost (HDA*)
+    Duplicate, // already on the path / in the table with a g at least as good
+    Reopened,  // already known, but reached with a smaller g
+    Goal,      // goal reached with this g
+    Bound,     // a threshold pass starts; `h` holds the threshold
+};
+
+/// The blank position of a node with no parent (the start state).
+constexpr std::uint16_t kTraceNoMove = 0xffff;
+static_assert(RingSize(kMaxGroupSize) < kTraceNoMove, "blank positions must fit TraceRecord::from/to");
+
+// Version 2 widened g and h from 16 bits (hierarchical paths on large rings
+// run past 32767 moves) and the blank positions from 8 (rings reach 1025).
+struct TraceRecord {
+    std::uint64_t stateHash; // ClosedTable::HashOf(state); 0 for Bound
+    std::int32_t g;
+    std::int32_t h;          // -1 where the solver did not evaluate it
+    std::uint16_t from;      // blank position in the parent (kTraceNoMove for the start)
+    std::uint16_t to;        // blank position in this state
+    TraceEvent event;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(TraceRecord) == 24, "trace files depend on the record size");
+
+/// The trace file. Shared by the buffers of all threads of one solve.
+class TraceRecorder {
+    std::ofstream out;
+    std::mutex mutex;
+
+  public:
+    /// Creates `path` and writes its header; `label` names what is traced (e.g. "ida:hop").
+    TraceRecorder(const std::string& path, std::size_t ringSize, const std::string& label);
+
+    /// False if the file could not be created or a write failed.
+    bool Good();
+
+    /// Append one chunk. Safe to call from several threads.
+    void Write(std::uint32_t thread, const TraceRecord* records, std::size_t count);
+};
+
+/// One thread's records on their way to a TraceRecorder. With no recorder,
+/// every call returns at once.
+class TraceBuffer {
+    static constexpr std::size_t kCapacity = 4096; // 96 KiB
+
+    TraceRecorder* recorder;
+    std::uint32_t thread;
+    std::unique_ptr<TraceRecord[]> records;
+    std::size_t used = 0;
+
+    void Append(const State& s, int g, int h, std::uint32_t from, TraceEvent event);
+
+  public:
+    explicit TraceBuffer(TraceRecorder* recorder, std::uint32_t thread = 0);
+    ~TraceBuffer() { Flush(); }
+    TraceBuffer(const TraceBuffer&) = delete;
+    TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    bool enabled() const { return recorder != nullptr; }
+
+    /// Log `s`. `from` is the parent's blank position (kTraceNoMove for none).
+    void Record(const State& s, int g, int h, std::uint32_t from, TraceEvent event) {
+        if (recorder != nullptr) Append(s, g, h, from, event);
+    }
+
+    /// Log the start of a threshold pass.
+    void RecordBound(int threshold);
+
+    /// Hand the buffered records to the recorder.
+    void Flush();
+};
+
+/// Reads a trace file record by record.
+class TraceReader {
+    std::ifstream in;
+    std::size_t ringSize = 0;
+    std::string traceLabel;
+    std::uint32_t chunkThread = 0;
+    std::uint32_t chunkLeft = 0;
+
+  public:
+    /// Throws std::runtime_error if `path` is not a trace file.
+    explicit TraceReader(const std::string& path);
+
+    std::size_t ring() const { return ringSize; }
+    const std::string& label() const { return traceLabel; }
+
+    /// The next record and the thread that wrote it. False at the end of the file.
+    bool Next(std::uint32_t& thread, TraceRecord& record);
+};
+
+/**
+ * Aggregates a trace and prints "[trace] ..." lines: counts per event and
+ * thread, expansions by depth (g) and by h, heuristic error hot spots, and
+ * the states expanded most often (transpositions).
+ *
+ * The error of a node's h is estimated against the cheapest goal in the
+ * trace, C*: slack = C* - g - h. It is the exact error for nodes on an
+ * optimal path and a lower bound for the rest; the (g, h) cells with the most
+ * expansions times slack are where a better heuristic would save most work.
+ * `top` bounds the hot-spot and transposition lists.
+ */
+void SummarizeTrace(TraceReader& trace, std::ostream& out, std::size_t top = 10);
+
+#endif // TRACE_H
@@ -4,4 +4,13 @@
 // Helper functions (hashing, printing, etc.)
 int WrapIndex(int i, int n);
 
+/// Hint that `p` will be read soon. No-op on compilers without the builtin.
+inline void PrefetchForRead(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
 #endif // UTIL_H
@@ -0,0 +1,204 @@
+#include "absolver.h"
+#include "group_size.h"
+#include "move_table.h"
+#include "perf_counters.h"
+#include "problem.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Recover the operator for each step of a solution path from the move table.
+std::vector<SolveStep> StepsFromPath(const Problem& p, const std::vector<State>& path) {
+    const MoveTable<kDynamicGroupSize> table(p);
+    std::vector<SolveStep> steps;
+    if (path.size() < 2) return steps;
+    steps.reserve(path.size() - 1);
+
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        const std::uint32_t from = path[i - 1].zeroIndex;
+        const std::uint32_t to = path[i].zeroIndex;
+        const BlankMoves& m = table[from];
+
+        std::uint32_t k = 0;
+        while (k < 4 && m.to[k] != to) ++k;
+        steps.push_back(SolveStep{static_cast<Move>(k < 4 ? k : 0), from, to});
+    }
+    return steps;
+}
+
+SolveStatus StatusFor(const SolveResult& result) {
+    switch (result.stopReason) {
+        case StopReason::None: break;
+        case StopReason::Cancelled: return SolveStatus::Cancelled;
+        case StopReason::Deadline:
+        case StopReason::NodeBudget: return SolveStatus::BudgetExceeded;
+    }
+    return result.solution.empty() ? SolveStatus::NoSolution : SolveStatus::Solved;
+}
+
+void FillResponse(SolveResponse& response, const Problem& p, SolveResult&& result) {
+    response.status = StatusFor(result);
+    response.stats = result.stats;
+    if (response.status == SolveStatus::Solved) {
+        response.moves = StepsFromPath(p, result.solution);
+        response.path = std::move(result.solution);
+    }
+}
+
+std::uint64_t MicrosSince(Clock::time_point started) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count());
+}
+
+SearchLimits LimitsFor(const SolveRequest& request, Clock::time_point started) {
+    SearchLimits limits;
+    limits.maxExpansions = request.nodeBudget;
+    limits.cancel = request.cancel;
+    if (request.timeBudget.count() > 0) limits.deadline = started + request.timeBudget;
+    return limits;
+}
+
+// Shared by both entry points; `getHeuristic` returns an initialized heuristic for `p`.
+template <typename GetHeuristic>
+SolveResponse SolveWith(const SolveRequest& request, GetHeuristic&& getHeuristic) {
+    const Clock::time_point started = Clock::now();
+    SolveResponse response;
+
+    response.error = ValidateRequest(request);
+    if (!response.error.empty()) {
+        response.status = SolveStatus::InvalidInput;
+        return response;
+    }
+
+    try {
+        const int n = GroupSizeForRing(request.large.size());
+        const Problem p(request.large, request.small, static_cast<uint16_t>(n));
+        // Opened first so that a heuristic initialized here is counted too.
+        PerfSession perf(request.perfCounters ? &response.perf : nullptr);
+        std::shared_ptr<Heuristic> heuristic = getHeuristic(p);
+
+        SolveOptions opts;
+        opts.solver = request.solver;
+        opts.threads = request.threads;
+        opts.limits = LimitsFor(request, started);
+        opts.checkpoint = request.checkpoint;
+        std::unique_ptr<TraceRecorder> trace;
+        if (!request.tracePath.empty()) {
+            trace.reset(new TraceRecorder(request.tracePath, request.large.size(),
+                                          std::string(ToString(request.solver)) + ":" + ToString(request.heuristic)));
+            opts.trace = trace.get();
+        }
+        SolveResult result = SolveProblem(p, *heuristic, request.heuristic, opts);
+        FillResponse(response, p, std::move(result));
+        if (trace != nullptr && !trace->Good()) {
+            // The answer stands; only the trace is lost.
+            response.error = "could not write trace " + request.tracePath;
+        }
+    } catch (const std::exception& e) {
+        response.status = SolveStatus::InvalidInput;
+        response.error = e.what();
+    }
+
+    response.elapsedMicros = MicrosSince(started);
+    return response;
+}
+
+// Requests that SolveBatch may run together: untraced A* with one heuristic and group size.
+bool CanInterleave(const SolveRequest& a, const SolveRequest& b) {
+    return a.solver == SolverKind::AStar && b.solver == SolverKind::AStar && a.heuristic == b.heuristic &&
+           a.large.size() == b.large.size() && a.tracePath.empty() && b.tracePath.empty();
+}
+
+} // namespace
+
+ABSolver::ABSolver(std::size_t cacheCapacity) : cache(cacheCapacity) {}
+
+SolveResponse ABSolver::Solve(const SolveRequest& request) {
+    return SolveWith(request, [&](const Problem& p) { return cache.Get(request.heuristic, p); });
+}
+
+std::vector<SolveResponse> ABSolver::SolveBatch(const std::vector<SolveRequest>& requests, bool interleave) {
+    const Clock::time_point started = Clock::now();
+    std::vector<SolveResponse> responses(requests.size());
+    std::vector<bool> done(requests.size(), false);
+
+    for (std::size_t first = 0; first < requests.size(); ++first) {
+        if (done[first]) continue;
+        const SolveRequest& request = requests[first];
+        if (!interleave || request.solver != SolverKind::AStar || !request.tracePath.empty() ||
+            !ValidateRequest(request).empty()) {
+            responses[first] = Solve(request);
+            done[first] = true;
+            continue;
+        }
+
+        // Gather every later A* request this one can share a run with.
+        std::vector<std::size_t> group;
+        std::vector<Problem> problems;
+        std::vector<std::shared_ptr<Heuristic>> owned;
+        std::vector<Heuristic*> heuristics;
+        std::vector<SearchLimits> limits;
+        const int n = GroupSizeForRing(request.large.size());
+        for (std::size_t i = first; i < requests.size(); ++i) {
+            if (done[i] || !CanInterleave(request, requests[i]) || !ValidateRequest(requests[i]).empty()) continue;
+            problems.emplace_back(requests[i].large, requests[i].small, static_cast<uint16_t>(n));
+            owned.push_back(cache.Get(requests[i].heuristic, problems.back()));
+            heuristics.push_back(owned.back().get());
+            limits.push_back(LimitsFor(requests[i], started));
+            group.push_back(i);
+            done[i] = true;
+        }
+
+        std::vector<SolveResult> results = SolveInterleaved(problems, heuristics, request.heuristic, limits);
+        const std::uint64_t elapsed = MicrosSince(started);
+        for (std::size_t k = 0; k < group.size(); ++k) {
+            SolveResponse& response = responses[group[k]];
+            FillResponse(response, problems[k], std::move(results[k]));
+            response.elapsedMicros = elapsed;
+        }
+    }
+    return responses;
+}
+
+SolveResponse Solve(const SolveRequest& request) {
+    return SolveWith(request, [&](const Problem& p) {
+        std::shared_ptr<Heuristic> heuristic = MakeHeuristic(request.heuristic);
+        heuristic->initialize(p);
+        return heuristic;
+    });
+}
+
+std::string ValidateRequest(const SolveRequest& request) {
+    if (request.large.size() != request.small.size()) {
+        return "large and small rings differ in size";
+    }
+    const int n = GroupSizeForRing(request.large.size());
+    if (n < 2 || RingSize(n) != request.large.size()) {
+        return "ring size must be n*n+1 with n >= 2";
+    }
+    if (n > kMaxGroupSize) {
+        return "group size above " + std::to_string(kMaxGroupSize) + " is not supported";
+    }
+    if (std::count(request.small.begin(), request.small.end(), Disk(0)) != 1) {
+        return "small ring must contain exactly one blank (0)";
+    }
+    return std::string();
+}
+
+const char* ToString(SolveStatus status) {
+    switch (status) {
+        case SolveStatus::Solved: return "solved";
+        case SolveStatus::NoSolution: return "nosolution";
+        case SolveStatus::Cancelled: return "cancelled";
+        case SolveStatus::BudgetExceeded: return "budget";
+        case SolveStatus::InvalidInput: return "invalid";
+    }
+    return "unknown";
+}
@@ -1,142 +1,837 @@
 #include "astar.h"
 #include "problem.h"
 #include "state.h"
+#include "checkpoint.h"
+#include "closed_table.h"
 #include "common.h"
-#include "util.h"
+#include "operator_table.h"
+#include "packed_state.h"
+#include "perf_counters.h"
+#include "solvability.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstdint>
 #include <deque>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <queue>
-#include <unordered_map>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
 #include <vector>
 
-AStar::AStar(const Problem &p, Heuristic &h): problem(p), heuristic(h)
+template <typename HeuristicT, int N>
+AStar<HeuristicT, N>::AStar(const Problem &p, HeuristicT &h, const SearchLimits &l, const CheckpointOptions &c,
+                            TraceRecorder *r)
+	: problem(p), heuristic(h), moves(p), limits(l), checkpoint(c), recorder(r)
 {
 	heuristic.initialize(problem);
 }
 
-bool CompareNodes(const Node* a, const Node* b) { return a->f() > b->f(); }
+namespace {
 
-Node GenerateMoveNode(Node * parent, Move move, uint32_t largeValue, const Heuristic & heuristic)
+// Frontier entry. f and g are copied out of the node so that heap operations
+// never touch nodes; an entry whose g no longer matches its node is stale.
+struct OpenEntry {
+	int f;
+	int g;
+	Node * node;
+};
+
+bool CompareEntries(const OpenEntry& a, const OpenEntry& b) { return a.f > b.f; }
+
+template <typename HeuristicT, int N>
+Node GenerateMoveNode(Node * parent, uint32_t to, const HeuristicT & heuristic)
 {
-	State state = {parent->state.small};
-
-	uint32_t numDisks = parent->state.small.size();
-	switch (move)
-	{
-		case SWAP_RIGHT:
-			state.zeroIndex = WrapIndex(parent->state.zeroIndex + largeValue, numDisks);
-			break;
-		case SWAP_LEFT:
-			state.zeroIndex = WrapIndex(parent->state.zeroIndex - largeValue, numDisks);
-			break;
-		case SWAP_N_RIGHT:
-			state.zeroIndex = WrapIndex(parent->state.zeroIndex + 1, numDisks);
-			break;
-		case SWAP_N_LEFT:
-			state.zeroIndex = WrapIndex(parent->state.zeroIndex - 1, numDisks);
-			break;
-		default: assert(false);
-	}
-
-	// Swap values
-	state.small[parent->state.zeroIndex] = state.small[state.zeroIndex];
-	state.small[state.zeroIndex] = 0;
-
-	Node node = {state,  parent->g + 1, heuristic(state), parent};
+	State state = parent->state;
+	ApplyBlankMove(state, to);
+
+	Node node = {state,  parent->g + 1, heuristic.template Evaluate<N>(state), parent};
 	return node;
 }
 
-uint32_t ExpandNode(Node * n, Node * outChildren, const std::vector<Disk> & large, const Heuristic & h)
+template <typename HeuristicT, int N>
+uint32_t ExpandNode(Node * n, Node * outChildren, const MoveTable<N> & moves, const HeuristicT & h)
+{
+	// Swap left and right, plus swap n left and right unless the large disk is 1.
+	const BlankMoves & m = moves[n->state.zeroIndex];
+	for (uint32_t i = 0; i < m.count; i++)
+	{
+		outChildren[i] = GenerateMoveNode<HeuristicT, N>(n, m.to[i], h);
+	}
+
+	return m.count;
+}
+
+// The h of every child, for partial expansion. Children in `exact` already
+// hold their exact h and are left alone. The others get their exact h and join
+// `exact`, except that a child above `limit` may get any lower bound above
+// `limit` instead and stay out. By default each child is evaluated in full.
+template <typename HeuristicT, int N>
+class ChildHeuristics
 {
-	uint32_t largeValue = large[n->state.zeroIndex];
+	const HeuristicT & heuristic;
 
-	// Add swap left and swap right states
-	outChildren[0] = GenerateMoveNode(n, SWAP_RIGHT, largeValue, h);
-	outChildren[1] = GenerateMoveNode(n, SWAP_LEFT,  largeValue, h);
+  public:
+	ChildHeuristics(const Problem &, const HeuristicT & h) : heuristic(h) {}
 
-	if (largeValue != 1)
+	void Evaluate(const State & s, const BlankMoves & m, int /*limit*/, int * childH, uint8_t & exact)
 	{
-		// Add swap n left and right states
-		outChildren[2] = GenerateMoveNode(n, SWAP_N_RIGHT, largeValue, h);
-		outChildren[3] = GenerateMoveNode(n, SWAP_N_LEFT,  largeValue, h);
-		return 4;
+		for (uint32_t i = 0; i < m.count; i++)
+		{
+			if (exact & (1u << i))
+			{
+				continue;
+			}
+			State child = s;
+			ApplyBlankMove(child, m.to[i]);
+			childH[i] = heuristic.template Evaluate<N>(child);
+			exact |= 1u << i;
+		}
 	}
+};
 
-	return 2;
-}
+// Under HopHeuristic: the parent's h per goal rotation, once, then each child
+// is the minimum over rotations after adding its operator table deltas.
+template <int N>
+class ChildHeuristics<HopHeuristic, N>
+{
+	const HopHeuristic & heuristic;
+	HopOperatorTable operators;
+	typename Ring<N>::template Array<int> rotationH;
 
-std::vector<State> AStar::solve(bool debug)
+  public:
+	ChildHeuristics(const Problem & p, const HopHeuristic & h) : heuristic(h)
+	{
+		operators.Build(p, h);
+	}
+
+	void Evaluate(const State & s, const BlankMoves & m, int /*limit*/, int * childH, uint8_t & exact)
+	{
+		const uint8_t all = static_cast<uint8_t>((1u << m.count) - 1);
+		if ((exact & all) == all)
+		{
+			return;
+		}
+		heuristic.template EvaluateRotations<N>(s, rotationH);
+		const uint32_t total = Ring<N>::Size(s.small);
+		for (uint32_t i = 0; i < m.count; i++)
+		{
+			if (exact & (1u << i))
+			{
+				continue;
+			}
+			const HopOperatorTable::Delta * delta = operators.Deltas(s.zeroIndex, i, s.small[m.to[i]]);
+			int best = std::numeric_limits<int>::max();
+			for (uint32_t rotation = 0; rotation < total; rotation++)
+			{
+				best = std::min(best, rotationH[rotation] + delta[rotation]);
+			}
+			childH[i] = best;
+		}
+		exact |= all;
+	}
+};
+
+// Under HopConflictHeuristic: its penalties only add to the hop sum, so the
+// table's hop h of a child is a lower bound, and only the children whose hop h
+// is within `limit` are evaluated in full.
+template <int N>
+class ChildHeuristics<HopConflictHeuristic, N>
 {
-	std::priority_queue<Node*, std::vector<Node*>, bool(*)(const Node*, const Node*)> frontier(CompareNodes);
-	std::unordered_map<State, Node*, StateHash> closed;
+	const HopConflictHeuristic & heuristic;
+	ChildHeuristics<HopHeuristic, N> hopSums;
+
+  public:
+	ChildHeuristics(const Problem & p, const HopConflictHeuristic & h) : heuristic(h), hopSums(p, h) {}
+
+	void Evaluate(const State & s, const BlankMoves & m, int limit, int * childH, uint8_t & exact)
+	{
+		uint8_t bounded = exact;
+		hopSums.Evaluate(s, m, limit, childH, bounded);
+		for (uint32_t i = 0; i < m.count; i++)
+		{
+			if ((exact & (1u << i)) || childH[i] > limit)
+			{
+				continue;
+			}
+			State child = s;
+			ApplyBlankMove(child, m.to[i]);
+			childH[i] = heuristic.template Evaluate<N>(child);
+			exact |= 1u << i;
+		}
+	}
+};
+
+// What the expansions of a node so far learned about its children under
+// partial expansion: the exact h of the children in `exact`, relative to the
+// node's h. A node put back is expanded again at each larger f, and would
+// otherwise evaluate the same children every time.
+struct KnownChildren
+{
+	int16_t h[4];
+	uint8_t exact = 0;
+};
+
+// The open list. The heap array is reachable so that a checkpoint can save it
+// and a resume can put back exactly the same one: ties in f pop in an order
+// that depends on the array, not just on its contents.
+struct Frontier : std::priority_queue<OpenEntry, std::vector<OpenEntry>, bool(*)(const OpenEntry&, const OpenEntry&)>
+{
+	Frontier() : priority_queue(CompareEntries) {}
+	using priority_queue::c;
+};
+
+const char kCheckpointMagic[9] = "ABASTCK1";
+constexpr uint64_t kNoNode = ~uint64_t(0);
+const CheckpointOptions kNoCheckpoint;
+
+// One A* search, advanced an expansion at a time in two phases. Expand() pops
+// a node, generates its children and prefetches the closed-set slots of the
+// node and its children; Commit() does the probes and inserts. Between the two
+// a caller can run other work (another search's phases) while the slots load.
+template <typename HeuristicT, int N>
+class Search {
+	const Problem & problem;
+	const HeuristicT & heuristic;
+	const MoveTable<N> & moves;
+	const SearchLimits & limits;
+
+	Frontier frontier;
+	ClosedTable closed;
 	std::deque<Node> nodes;
+	Node * goal = NULL;
+
+	// The node expanded by the last Expand() and its children, with hashes.
+	Node * parent = NULL;
+	uint64_t parentHash = 0;
+	Node children[4];
+	uint64_t childHashes[4];
+	uint32_t childCount = 0;
 
-	State startState = problem.smallState;
-	nodes.push_back(Node{startState, 0, heuristic(startState), NULL});
-	frontier.push(&nodes[0]);
+	// Checkpoints (see checkpoint.h). The log gets what changed since the
+	// last checkpoint: nodes from `loggedNodes` on, then these two lists.
+	const CheckpointOptions & checkpoint;
+	const uint64_t fingerprint;
+	const unsigned bitsPerDisk;
+	size_t loggedNodes = 0;
+	std::vector<Node*> reopened;
+	std::vector<Node*> newlyClosed;
+	uint64_t logBytes = 0;
+	SearchLimits::Clock::time_point nextCheckpoint;
+	// Popped and counted, but not expanded yet when the checkpoint was taken.
+	Node * resumeNode = NULL;
 
-	while (!frontier.empty())
+	// Partial expansion (EPEA*): Expand() only builds the children whose f is
+	// the popped entry's f, and Commit() puts the parent back with `nextF`,
+	// the smallest child f above it, if there is one.
+	const bool partial;
+	std::unique_ptr<ChildHeuristics<HeuristicT, N>> childHeuristics;
+	std::vector<KnownChildren> knownChildren; // by node id
+	int nextF = 0;
+
+	// Hardware counters (see perf_counters.h) only read every kPerfSampleInterval-th Expand() and Commit().
+	uint64_t perfTicks = 0;
+	bool perfSampled = false;
+
+	TraceBuffer trace;
+
+	uint32_t ExpandPartially(Node * n, int f)
 	{
-		Node * n = frontier.top();
-		frontier.pop();
-		if (n->state.IsGoal(problem.n))
+		const BlankMoves & m = moves[n->state.zeroIndex];
+		if (knownChildren.size() < nodes.size())
 		{
-			// return path.
-			std::vector<State> solution;
-			Node* current = n;
-			solution.push_back(current->state);
-			while (current->parent != NULL)
+			knownChildren.resize(nodes.size());
+		}
+		KnownChildren & known = knownChildren[n->id];
+		int childH[4];
+		for (uint32_t i = 0; i < m.count; i++)
+		{
+			if (known.exact & (1u << i))
 			{
-				current = current->parent;
-				solution.push_back(current->state);
+				childH[i] = n->h + known.h[i];
 			}
-			std::reverse(solution.begin(), solution.end());
-			if (debug)
+		}
+		uint8_t exact = known.exact;
+		childHeuristics->Evaluate(n->state, m, f - n->g - 1, childH, exact);
+		for (uint32_t i = 0; i < m.count; i++)
+		{
+			const int delta = childH[i] - n->h;
+			if ((exact & ~known.exact & (1u << i)) && delta >= std::numeric_limits<int16_t>::min() &&
+			    delta <= std::numeric_limits<int16_t>::max())
+			{
+				known.h[i] = static_cast<int16_t>(delta);
+				known.exact |= static_cast<uint8_t>(1u << i);
+			}
+		}
+
+		// Children below f(n) only come with an inconsistent heuristic; the
+		// first expansion takes them along, later ones built them already.
+		// `nextF` may come from a lower bound (see ChildHeuristics); the
+		// expansion at that f then evaluates the child in full.
+		const bool first = f == n->f();
+		nextF = std::numeric_limits<int>::max();
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < m.count; i++)
+		{
+			const int childF = n->g + 1 + childH[i];
+			if (childF > f)
+			{
+				nextF = std::min(nextF, childF);
+				continue;
+			}
+			if (childF < f && !first)
 			{
-				std::cout << "Number of nodes: " <<nodes.size() << std::endl;
-				std::cout << "Moves to solve: " << solution.size() << std::endl;
+				continue;
 			}
-			return solution;
+			State state = n->state;
+			ApplyBlankMove(state, m.to[i]);
+			children[count++] = Node{state, n->g + 1, childH[i], n};
+		}
+		return count;
+	}
+
+	static uint32_t BlankOf(const Node * node) { return node != NULL ? node->state.zeroIndex : kTraceNoMove; }
+
+	Node * AddNode(Node && node)
+	{
+		node.id = nodes.size();
+		nodes.push_back(std::move(node));
+		return &nodes.back();
+	}
+
+	static uint64_t IdOf(const Node * node) { return node != NULL ? node->id : kNoNode; }
+
+	void WriteCheckpoint(const Node * pending)
+	{
+		nextCheckpoint = SearchLimits::Clock::now() + checkpoint.interval;
+
+		const std::string openPath = checkpoint.path + ".open";
+		if (logBytes == 0)
+		{
+			// An open list left by an earlier run would not match the new log.
+			std::remove(openPath.c_str());
+		}
+
+		// The log: appended, so each checkpoint only costs what changed.
+		CheckpointWriter log(checkpoint.path, /*append=*/logBytes != 0);
+		if (logBytes == 0)
+		{
+			log.PutHeader(kCheckpointMagic, fingerprint);
+		}
+		log.Put(static_cast<uint64_t>(nodes.size() - loggedNodes));
+		for (size_t i = loggedNodes; i < nodes.size(); i++)
+		{
+			const Node & node = nodes[i];
+			log.PutState(node.state, bitsPerDisk);
+			log.Put(node.g);
+			log.Put(node.h);
+			log.Put(IdOf(node.parent));
+		}
+		log.Put(static_cast<uint64_t>(reopened.size()));
+		for (const Node * node : reopened)
+		{
+			log.Put(node->id);
+			log.Put(node->g);
+			log.Put(IdOf(node->parent));
+		}
+		log.Put(static_cast<uint64_t>(newlyClosed.size()));
+		for (const Node * node : newlyClosed)
+		{
+			log.Put(node->id);
+		}
+		const uint64_t end = log.Position();
+		if (!log.Finish())
+		{
+			WarnCheckpointFailed(checkpoint.path);
+			return;
+		}
+		logBytes = end;
+		loggedNodes = nodes.size();
+		reopened.clear();
+		newlyClosed.clear();
+
+		// The open list and counters: small next to the log, rewritten whole.
+		const std::string tmpPath = openPath + ".tmp";
+		CheckpointWriter open(tmpPath, /*append=*/false);
+		open.PutHeader(kCheckpointMagic, fingerprint);
+		open.Put(logBytes);
+		open.Put(stats.expanded);
+		open.Put(stats.generated);
+		open.Put(IdOf(pending));
+		open.Put(static_cast<uint64_t>(frontier.c.size()));
+		for (const OpenEntry & entry : frontier.c)
+		{
+			open.Put(entry.g);
+			open.Put(entry.node->id);
+		}
+		if (!open.Finish() || !ReplaceCheckpointFile(tmpPath, openPath))
+		{
+			WarnCheckpointFailed(openPath);
+		}
+	}
+
+	// Rebuild the search from the log and the last open list that refers to it.
+	bool ReadCheckpoint()
+	{
+		const std::string openPath = checkpoint.path + ".open";
+		CheckpointReader open(openPath);
+		CheckpointReader log(checkpoint.path);
+		if (!open.IsOpen() || !log.IsOpen())
+		{
+			return false;
+		}
+		open.ExpectHeader(kCheckpointMagic, fingerprint, openPath);
+		log.ExpectHeader(kCheckpointMagic, fingerprint, checkpoint.path);
+
+		uint64_t pendingId = kNoNode, openCount = 0;
+		bool ok = open.Get(logBytes) && open.Get(stats.expanded) && open.Get(stats.generated) &&
+		          open.Get(pendingId) && open.Get(openCount);
+
+		nodes.clear();
+		closed = ClosedTable();
+		// A section the open list does not cover yet was cut short by a crash.
+		while (ok && log.Position() < logBytes)
+		{
+			uint64_t count = 0;
+			ok = log.Get(count);
+			for (uint64_t i = 0; ok && i < count; i++)
+			{
+				Node node;
+				uint64_t parentId = kNoNode;
+				ok = log.GetState(node.state, problem.large.size(), bitsPerDisk) &&
+				     log.Get(node.g) && log.Get(node.h) && log.Get(parentId) &&
+				     (parentId == kNoNode || parentId < nodes.size());
+				node.parent = ok && parentId != kNoNode ? &nodes[parentId] : NULL;
+				if (ok)
+				{
+					AddNode(std::move(node));
+				}
+			}
+			ok = ok && log.Get(count);
+			for (uint64_t i = 0; ok && i < count; i++)
+			{
+				uint64_t id = 0, parentId = kNoNode;
+				int g = 0;
+				ok = log.Get(id) && log.Get(g) && log.Get(parentId) && id < nodes.size() &&
+				     (parentId == kNoNode || parentId < nodes.size());
+				if (ok)
+				{
+					nodes[id].g = g;
+					nodes[id].parent = parentId != kNoNode ? &nodes[parentId] : NULL;
+				}
+			}
+			ok = ok && log.Get(count);
+			for (uint64_t i = 0; ok && i < count; i++)
+			{
+				uint64_t id = 0;
+				ok = log.Get(id) && id < nodes.size();
+				if (ok)
+				{
+					closed.Insert(&nodes[id], ClosedTable::HashOf(nodes[id].state));
+				}
+			}
+		}
+		ok = ok && log.Position() == logBytes && (pendingId == kNoNode || pendingId < nodes.size());
+
+		frontier.c.clear();
+		for (uint64_t i = 0; ok && i < openCount; i++)
+		{
+			int g = 0;
+			uint64_t id = 0;
+			ok = open.Get(g) && open.Get(id) && id < nodes.size();
+			if (ok)
+			{
+				frontier.c.push_back(OpenEntry{g + nodes[id].h, g, &nodes[id]});
+			}
+		}
+		if (!ok)
+		{
+			throw std::runtime_error("truncated or inconsistent checkpoint: " + checkpoint.path);
+		}
+
+		resumeNode = pendingId != kNoNode ? &nodes[pendingId] : NULL;
+		loggedNodes = nodes.size();
+		// Drop a tail written after the open list was last replaced.
+		TruncateCheckpointFile(checkpoint.path, logBytes);
+		return true;
+	}
+
+  public:
+	SearchStats stats;
+	StopReason stop = StopReason::None;
+	bool resumed = false;
+	uint64_t reexpanded = 0; // partial expansion: pops of a node put back
+
+	Search(const Problem &p, const HeuristicT &h, const MoveTable<N> &m, const SearchLimits &l,
+	       const CheckpointOptions &c, TraceRecorder * recorder, bool partialExpansion = false)
+		: problem(p), heuristic(h), moves(m), limits(l), checkpoint(c),
+		  fingerprint(CheckpointFingerprint(p, "astar", typeid(HeuristicT).name())), bitsPerDisk(BitsPerDisk(p.n)),
+		  partial(partialExpansion), trace(recorder)
+	{
+		stats.iterations = 1;
+		if (partial)
+		{
+			childHeuristics.reset(new ChildHeuristics<HeuristicT, N>(problem, heuristic));
+		}
+		if (checkpoint.resume && ReadCheckpoint())
+		{
+			resumed = true;
 		}
 		else
 		{
-			closed[n->state] = n;
+			const State & start = problem.smallState;
+			AddNode(Node{start, 0, heuristic.template Evaluate<N>(start), NULL});
+			frontier.push(OpenEntry{nodes[0].f(), 0, &nodes[0]});
+		}
+		nextCheckpoint = SearchLimits::Clock::now() + checkpoint.interval;
+	}
 
-			// Expand node
-			Node children[4];
-			uint16_t childCount = ExpandNode(n, children, problem.large, heuristic);
+	// False once the search is over: goal reached, frontier empty or limits hit.
+	bool Expand()
+	{
+		perfSampled = ++perfTicks % kPerfSampleInterval == 0;
+		PerfScope perf(PerfPhase::AStarExpand, perfSampled);
+		Node * n = resumeNode;
+		resumeNode = NULL;
+		int f = n != NULL ? n->f() : 0;
+		if (n == NULL)
+		{
+			while (n == NULL)
+			{
+				if (frontier.empty())
+				{
+					return false;
+				}
+				const OpenEntry entry = frontier.top();
+				frontier.pop();
+				if (entry.g == entry.node->g)
+				{
+					n = entry.node;
+					f = entry.f;
+				}
+			}
+			if (n->state.IsGoal<N>(problem.n))
+			{
+				trace.Record(n->state, n->g, n->h, BlankOf(n->parent), TraceEvent::Goal);
+				goal = n;
+				return false;
+			}
+
+			stop = limits.Check(++stats.expanded);
+			if (stop != StopReason::None)
+			{
+				if (checkpoint.enabled())
+				{
+					WriteCheckpoint(n);
+				}
+				return false;
+			}
+			trace.Record(n->state, n->g, n->h, BlankOf(n->parent), TraceEvent::Expanded);
+		}
+
+		parent = n;
+		parentHash = ClosedTable::HashOf(n->state);
+		closed.Prefetch(parentHash);
+
+		if (partial)
+		{
+			reexpanded += f != n->f();
+			childCount = ExpandPartially(n, f);
+		}
+		else
+		{
+			childCount = ExpandNode<HeuristicT, N>(n, children, moves, heuristic);
+		}
+		stats.generated += childCount;
+		for (uint32_t i = 0; i < childCount; i++)
+		{
+			childHashes[i] = ClosedTable::HashOf(children[i].state);
+			closed.Prefetch(childHashes[i]);
+		}
+		perf.Stop(1);
+		return true;
+	}
 
-			for (int i = 0; i < childCount; i++)
+	// Close the node from the last Expand() and queue its children.
+	void Commit()
+	{
+		PerfScope perf(PerfPhase::AStarProbe, perfSampled);
+		closed.Insert(parent, parentHash);
+		if (checkpoint.enabled())
+		{
+			newlyClosed.push_back(parent);
+		}
+
+		for (uint32_t i = 0; i < childCount; i++)
+		{
+			Node * child = &children[i];
+			// Check if child is in closed set.
+			Node * existingChild = closed.Find(child->state, childHashes[i]);
+			if (existingChild != NULL)
 			{
-				Node * child = &children[i];
-				// Check if child is in closed set.
-				auto it = closed.find(child->state);
-				if (it != closed.end())
+				// Check if cost to new node is less
+				if (child->g < existingChild->g)
 				{
-					// Check if cost to new node is less
-					Node * existingChild = it->second;
-					if (child->g < existingChild->g)
+					trace.Record(child->state, child->g, child->h, parent->state.zeroIndex, TraceEvent::Reopened);
+					// Update existing node with new cost and parent.
+					existingChild->g = child->g;
+					existingChild->parent = parent;
+					// Reopen node
+					frontier.push(OpenEntry{existingChild->f(), existingChild->g, existingChild});
+					if (checkpoint.enabled())
 					{
-						// Update existing node with new cost and parent.
-						existingChild->g = child->g;
-						existingChild->parent = n;
-						// Reopen node
-						frontier.push(existingChild);
+						reopened.push_back(existingChild);
 					}
 				}
 				else
 				{
-					// New node, store and add to frontier.
-					nodes.push_back(*child);
-					frontier.push(&nodes.back());
+					trace.Record(child->state, child->g, child->h, parent->state.zeroIndex, TraceEvent::Duplicate);
 				}
 			}
+			else
+			{
+				// New node, store and add to frontier.
+				Node * node = AddNode(std::move(*child));
+				frontier.push(OpenEntry{node->f(), node->g, node});
+			}
+		}
+
+		if (partial && nextF != std::numeric_limits<int>::max())
+		{
+			frontier.push(OpenEntry{nextF, parent->g, parent});
+		}
+
+		if (!frontier.empty())
+		{
+			// The next node to expand, unless its entry is stale.
+			PrefetchForRead(frontier.top().node);
+		}
+		perf.Stop(1);
+
+		if (checkpoint.enabled() && stats.expanded % kLimitCheckInterval == 0 &&
+		    SearchLimits::Clock::now() >= nextCheckpoint)
+		{
+			WriteCheckpoint(NULL);
+		}
+	}
+
+	std::size_t NodeCount() const { return nodes.size(); }
+
+	// Start to goal inclusive; empty unless a goal was reached.
+	std::vector<State> Path() const
+	{
+		std::vector<State> solution;
+		for (const Node * current = goal; current != NULL; current = current->parent)
+		{
+			solution.push_back(current->state);
+		}
+		std::reverse(solution.begin(), solution.end());
+		return solution;
+	}
+};
+
+} // namespace
+
+template <typename HeuristicT, int N>
+std::vector<State> AStar<HeuristicT, N>::solve(bool debug)
+{
+	searchStats = SearchStats();
+	searchStats.iterations = 1;
+	stop = StopReason::None;
+
+	// Without this, an unreachable goal would expand the whole reachable space.
+	const Solvability solvability = AnalyzeSolvability(problem);
+	if (debug)
+	{
+		std::cout << "[A*] pre-check: " << ToString(solvability) << std::endl;
+	}
+	if (solvability == Solvability::Unsolvable)
+	{
+		return {};
+	}
+
+	Search<HeuristicT, N> search(problem, heuristic, moves, limits, checkpoint, recorder);
+	if (debug && search.resumed)
+	{
+		std::cout << "[A*] resumed nodes=" << search.NodeCount() << " expanded=" << search.stats.expanded << std::endl;
+	}
+	while (search.Expand())
+	{
+		search.Commit();
+	}
+
+	searchStats = search.stats;
+	stop = search.stop;
+	if (stop != StopReason::None)
+	{
+		if (debug)
+		{
+			std::cout << "[A*] stopped (limits exceeded) nodes=" << search.NodeCount() << std::endl;
+		}
+		return {};
+	}
+
+	std::vector<State> solution = search.Path();
+	if (debug && !solution.empty())
+	{
+		std::cout << "Number of nodes: " << search.NodeCount() << std::endl;
+		std::cout << "Moves to solve: " << solution.size() << std::endl;
+	}
+	return solution;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> AStar<HeuristicT, N>::solve()
+{
+	return solve(false);
+}
+
+template <typename HeuristicT, int N>
+EPEAStar<HeuristicT, N>::EPEAStar(const Problem &p, HeuristicT &h, const SearchLimits &l, TraceRecorder *r)
+	: problem(p), heuristic(h), moves(p), limits(l), recorder(r)
+{
+	heuristic.initialize(problem);
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> EPEAStar<HeuristicT, N>::solve(bool debug)
+{
+	searchStats = SearchStats();
+	searchStats.iterations = 1;
+	stop = StopReason::None;
+
+	const Solvability solvability = AnalyzeSolvability(problem);
+	if (debug)
+	{
+		std::cout << "[EPEA*] pre-check: " << ToString(solvability) << std::endl;
+	}
+	if (solvability == Solvability::Unsolvable)
+	{
+		return {};
+	}
+
+	Search<HeuristicT, N> search(problem, heuristic, moves, limits, kNoCheckpoint, recorder, /*partialExpansion=*/true);
+	while (search.Expand())
+	{
+		search.Commit();
+	}
+
+	searchStats = search.stats;
+	stop = search.stop;
+	if (stop != StopReason::None)
+	{
+		if (debug)
+		{
+			std::cout << "[EPEA*] stopped (limits exceeded) nodes=" << search.NodeCount() << std::endl;
+		}
+		return {};
+	}
+
+	std::vector<State> solution = search.Path();
+	if (debug && !solution.empty())
+	{
+		std::cout << "[EPEA*] solved cost=" << solution.size() - 1
+		          << " nodes=" << search.NodeCount()
+		          << " expanded=" << searchStats.expanded
+		          << " reexpanded=" << search.reexpanded
+		          << " generated=" << searchStats.generated
+		          << std::endl;
+	}
+	return solution;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> EPEAStar<HeuristicT, N>::solve()
+{
+	return solve(false);
+}
+
+template <typename HeuristicT, int N>
+InterleavedAStar<HeuristicT, N>::InterleavedAStar(const std::vector<Problem> &p, const std::vector<HeuristicT *> &h,
+                                                  const std::vector<SearchLimits> &l)
+	: problems(p), heuristics(h), limits(l), searchStats(p.size()), stops(p.size(), StopReason::None)
+{
+	assert(heuristics.size() == problems.size() && limits.size() == problems.size());
+	moves.reserve(problems.size());
+	for (std::size_t i = 0; i < problems.size(); i++)
+	{
+		heuristics[i]->initialize(problems[i]);
+		moves.emplace_back(problems[i]);
+	}
+}
+
+template <typename HeuristicT, int N>
+std::vector<std::vector<State>> InterleavedAStar<HeuristicT, N>::solve(bool debug)
+{
+	std::vector<std::vector<State>> solutions(problems.size());
+	std::vector<std::unique_ptr<Search<HeuristicT, N>>> searches(problems.size());
+
+	// Searches still running; finished ones drop out of the rotation.
+	std::vector<std::size_t> active;
+	for (std::size_t i = 0; i < problems.size(); i++)
+	{
+		stops[i] = StopReason::None;
+		searchStats[i] = SearchStats();
+		searchStats[i].iterations = 1;
+
+		const Solvability solvability = AnalyzeSolvability(problems[i]);
+		if (debug)
+		{
+			std::cout << "[A*x] instance " << i << " pre-check: " << ToString(solvability) << std::endl;
+		}
+		if (solvability == Solvability::Unsolvable)
+		{
+			continue;
 		}
+		searches[i].reset(new Search<HeuristicT, N>(problems[i], *heuristics[i], moves[i], limits[i], kNoCheckpoint, NULL));
+		active.push_back(i);
 	}
 
-    return {};
+	std::vector<std::size_t> expanded;
+	while (!active.empty())
+	{
+		// First phase for everyone, then the second: each search's prefetches
+		// have the other searches' expansions to complete behind.
+		expanded.clear();
+		for (std::size_t i : active)
+		{
+			Search<HeuristicT, N> & search = *searches[i];
+			if (search.Expand())
+			{
+				expanded.push_back(i);
+				continue;
+			}
+
+			searchStats[i] = search.stats;
+			stops[i] = search.stop;
+			if (stops[i] == StopReason::None)
+			{
+				solutions[i] = search.Path();
+			}
+			if (debug)
+			{
+				std::cout << "[A*x] instance " << i << " done nodes=" << search.NodeCount()
+				          << " cost=" << (solutions[i].empty() ? -1 : static_cast<int>(solutions[i].size()) - 1)
+				          << std::endl;
+			}
+			searches[i].reset();
+		}
+		for (std::size_t i : expanded)
+		{
+			searches[i]->Commit();
+		}
+		active.swap(expanded);
+	}
+	return solutions;
 }
+
+#define INSTANTIATE_ASTAR(H) AB_INSTANTIATE_FOR_GROUP_SIZES(AStar, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_ASTAR)
+#define INSTANTIATE_EPEA_STAR(H) AB_INSTANTIATE_FOR_GROUP_SIZES(EPEAStar, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_EPEA_STAR)
+#define INSTANTIATE_INTERLEAVED_ASTAR(H) AB_INSTANTIATE_FOR_GROUP_SIZES(InterleavedAStar, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_INTERLEAVED_ASTAR)
@@ -0,0 +1,255 @@
+#include "bfhs.h"
+
+#include "packed_state.h"
+#include "solvability.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::uint32_t kNoRelay = ~std::uint32_t(0);
+
+// Layers kept behind the one being expanded, for duplicate detection. On the
+// benchmark instances keeping every layer would save up to a tenth of the
+// expansions, at A*'s memory; one layer fewer costs about as much again.
+constexpr std::size_t kKeptLayers = 2;
+
+struct LayerEntry {
+    std::uint32_t relay; // index into the relay states, or kNoRelay above the relay layer
+    int h;
+};
+
+using Layer = std::unordered_map<PackedState, LayerEntry, PackedStateHash>;
+
+bool Contains(const Layer &layer, const PackedState &key) { return layer.find(key) != layer.end(); }
+
+} // namespace
+
+template <typename HeuristicT, int N>
+struct BreadthFirstHeuristicSearch<HeuristicT, N>::LayerResult {
+    bool found = false;
+    int depth = 0;      // where `reached` was found
+    State reached;
+    bool hasRelay = false;
+    int relayDepth = 0;
+    State relay;        // the relay-layer ancestor of `reached`, if hasRelay
+    int nextBound = std::numeric_limits<int>::max(); // smallest f cut off
+    std::uint64_t widest = 0;
+};
+
+template <typename HeuristicT, int N>
+BreadthFirstHeuristicSearch<HeuristicT, N>::BreadthFirstHeuristicSearch(const Problem &p, HeuristicT &h,
+                                                                        const SearchLimits &l, TraceRecorder *r)
+    : problem(p), heuristic(h), moves(p), limits(l), trace(r) {
+    heuristic.initialize(problem);
+}
+
+template <typename HeuristicT, int N>
+typename BreadthFirstHeuristicSearch<HeuristicT, N>::LayerResult
+BreadthFirstHeuristicSearch<HeuristicT, N>::searchLayers(const State &from, int fromDepth, int maxDepth, int bound,
+                                                         const State *target) {
+    const unsigned bitsPerDisk = BitsPerDisk(problem.n);
+    const std::size_t ringSize = problem.large.size();
+    auto isTarget = [&](const State &s) { return target != nullptr ? s == *target : s.IsGoal<N>(problem.n); };
+
+    LayerResult result;
+    // Too short to split: the caller needs no relay.
+    result.relayDepth = maxDepth - fromDepth >= 2 ? (fromDepth + maxDepth) / 2 : -1;
+    std::vector<PackedState> relays;
+
+    trace.RecordBound(bound);
+    if (isTarget(from)) {
+        result.found = true;
+        result.depth = fromDepth;
+        result.reached = from;
+        return result;
+    }
+
+    std::deque<Layer> kept;
+    Layer current;
+    current.emplace(PackedState(from, bitsPerDisk), LayerEntry{kNoRelay, heuristic.template Evaluate<N>(from)});
+    std::size_t keptSize = 0;
+
+    for (int depth = fromDepth; depth < maxDepth && !current.empty(); ++depth) {
+        Layer next;
+        const int g = depth + 1;
+        for (const auto &entry : current) {
+            const State s = entry.first.Unpack(ringSize, bitsPerDisk);
+            trace.Record(s, depth, entry.second.h, kTraceNoMove, TraceEvent::Expanded);
+            stop = limits.Check(++searchStats.expanded);
+            if (stop != StopReason::None) {
+                return result;
+            }
+
+            const BlankMoves &m = moves[s.zeroIndex];
+            for (uint32_t i = 0; i < m.count; ++i) {
+                State child = s;
+                ApplyBlankMove(child, m.to[i]);
+                ++searchStats.generated;
+
+                PackedState key(child, bitsPerDisk);
+                bool seen = Contains(next, key) || Contains(current, key);
+                for (std::size_t k = 0; !seen && k < kept.size(); ++k) {
+                    seen = Contains(kept[k], key);
+                }
+                if (seen) {
+                    trace.Record(child, g, -1, s.zeroIndex, TraceEvent::Duplicate);
+                    continue;
+                }
+
+                const int h = heuristic.template Evaluate<N>(child);
+                if (g + h > bound) {
+                    trace.Record(child, g, h, s.zeroIndex, TraceEvent::Pruned);
+                    result.nextBound = std::min(result.nextBound, g + h);
+                    continue;
+                }
+
+                std::uint32_t relay = entry.second.relay;
+                if (g == result.relayDepth) {
+                    relay = static_cast<std::uint32_t>(relays.size());
+                    relays.push_back(key);
+                }
+
+                if (isTarget(child)) {
+                    if (target == nullptr) {
+                        trace.Record(child, g, h, s.zeroIndex, TraceEvent::Goal);
+                    }
+                    result.found = true;
+                    result.depth = g;
+                    result.reached = std::move(child);
+                    result.hasRelay = relay != kNoRelay && g > result.relayDepth;
+                    if (result.hasRelay) {
+                        result.relay = relays[relay].Unpack(ringSize, bitsPerDisk);
+                    }
+                    return result;
+                }
+                next.emplace(std::move(key), LayerEntry{relay, h});
+            }
+        }
+
+        result.widest = std::max<std::uint64_t>(result.widest, next.size());
+        keptSize += current.size();
+        kept.push_back(std::move(current));
+        if (kept.size() > kKeptLayers) {
+            keptSize -= kept.front().size();
+            kept.pop_front();
+        }
+        current = std::move(next);
+        peakStored = std::max(peakStored, keptSize + current.size() + relays.size());
+    }
+    return result;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> BreadthFirstHeuristicSearch<HeuristicT, N>::recover(const State &from, int fromDepth,
+                                                                       const LayerResult &result, int bound) {
+    if (!result.hasRelay) {
+        return findPath(from, fromDepth, result.reached, result.depth, bound);
+    }
+
+    std::vector<State> path = findPath(from, fromDepth, result.relay, result.relayDepth, bound);
+    if (path.empty()) {
+        return path;
+    }
+    std::vector<State> rest = findPath(result.relay, result.relayDepth, result.reached, result.depth, bound);
+    if (rest.empty()) {
+        return rest;
+    }
+    // Both halves hold the relay state.
+    path.insert(path.end(), rest.begin() + 1, rest.end());
+    return path;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> BreadthFirstHeuristicSearch<HeuristicT, N>::findPath(const State &from, int fromDepth,
+                                                                        const State &target, int targetDepth,
+                                                                        int bound) {
+    if (targetDepth - fromDepth <= 1) {
+        // One move apart (or the same state): nothing to search.
+        if (from == target) {
+            return {from};
+        }
+        return {from, target};
+    }
+
+    const LayerResult result = searchLayers(from, fromDepth, targetDepth, bound, &target);
+    if (stop != StopReason::None) {
+        return {};
+    }
+    if (!result.found) {
+        throw std::logic_error("BFHS path recovery lost a state on the optimal path");
+    }
+    return recover(from, fromDepth, result, bound);
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> BreadthFirstHeuristicSearch<HeuristicT, N>::solve(bool debug) {
+    searchStats = SearchStats();
+    stop = StopReason::None;
+    peakStored = 0;
+
+    const Solvability solvability = AnalyzeSolvability(problem);
+    if (debug) {
+        std::cout << "[BFHS] pre-check: " << ToString(solvability) << std::endl;
+    }
+    if (solvability == Solvability::Unsolvable) {
+        return {};
+    }
+
+    const State &start = problem.smallState;
+    int bound = heuristic.template Evaluate<N>(start);
+    while (true) {
+        ++searchStats.iterations;
+        // f <= bound and h >= 0 keep every node within `bound` moves of the start.
+        const LayerResult result = searchLayers(start, 0, bound, bound, nullptr);
+        if (debug) {
+            std::cout << "[BFHS] bound=" << bound
+                      << " expanded=" << searchStats.expanded
+                      << " widest=" << result.widest
+                      << " peak_stored=" << peakStored
+                      << std::endl;
+        }
+
+        if (stop != StopReason::None) {
+            if (debug) {
+                std::cout << "[BFHS] stopped (limits exceeded) expanded=" << searchStats.expanded << std::endl;
+            }
+            return {};
+        }
+
+        if (result.found) {
+            // h is admissible, so every state on an optimal path has f <= the goal's depth.
+            const std::uint64_t searched = searchStats.expanded;
+            std::vector<State> solution = recover(start, 0, result, result.depth);
+            if (debug && !solution.empty()) {
+                std::cout << "[BFHS] solved cost=" << result.depth
+                          << " recovery_expanded=" << searchStats.expanded - searched
+                          << " peak_stored=" << peakStored
+                          << std::endl;
+            }
+            return solution;
+        }
+
+        if (result.nextBound == std::numeric_limits<int>::max()) {
+            if (debug) {
+                std::cout << "[BFHS] no solution expanded=" << searchStats.expanded << std::endl;
+            }
+            return {};
+        }
+        bound = result.nextBound;
+    }
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> BreadthFirstHeuristicSearch<HeuristicT, N>::solve() {
+    return solve(false);
+}
+
+#define INSTANTIATE_BFHS(H) AB_INSTANTIATE_FOR_GROUP_SIZES(BreadthFirstHeuristicSearch, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_BFHS)
@@ -0,0 +1,81 @@
+#include "checkpoint.h"
+
+#include "packed_state.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+CheckpointWriter::CheckpointWriter(const std::string& path, bool append)
+    : out(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc)) {}
+
+void CheckpointWriter::PutState(const State& s, unsigned bitsPerDisk) {
+    const PackedState packed(s, bitsPerDisk);
+    for (std::uint64_t w : packed.Words()) Put(w);
+}
+
+void CheckpointWriter::PutHeader(const char (&magic)[9], std::uint64_t fingerprint) {
+    out.write(magic, 8);
+    Put(fingerprint);
+}
+
+bool CheckpointWriter::Finish() {
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+CheckpointReader::CheckpointReader(const std::string& path) : in(path, std::ios::binary) {}
+
+bool CheckpointReader::GetState(State& s, std::size_t ringSize, unsigned bitsPerDisk) {
+    std::vector<std::uint64_t> words(PackedState::WordCount(ringSize, bitsPerDisk));
+    for (std::uint64_t& w : words) {
+        if (!Get(w)) return false;
+    }
+    s = PackedState(std::move(words)).Unpack(ringSize, bitsPerDisk);
+    return true;
+}
+
+void CheckpointReader::ExpectHeader(const char (&magic)[9], std::uint64_t fingerprint, const std::string& path) {
+    char tag[8];
+    std::uint64_t stored = 0;
+    if (!in.read(tag, 8) || std::memcmp(tag, magic, 8) != 0 || !Get(stored)) {
+        throw std::runtime_error("not a checkpoint of this solver: " + path);
+    }
+    if (stored != fingerprint) {
+        throw std::runtime_error("checkpoint belongs to another instance or heuristic: " + path);
+    }
+}
+
+/// FNV-1a over the layout, the start state and both names.
+std::uint64_t CheckpointFingerprint(const Problem& p, const char* solver, const char* heuristic) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    auto mix = [&h](const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            h ^= bytes[i];
+            h *= 0x100000001b3ULL;
+        }
+    };
+    mix(&p.n, sizeof(p.n));
+    mix(p.large.data(), p.large.size());
+    mix(p.smallState.small.data(), p.smallState.small.size());
+    mix(solver, std::strlen(solver) + 1);
+    mix(heuristic, std::strlen(heuristic) + 1);
+    return h;
+}
+
+bool ReplaceCheckpointFile(const std::string& tmpPath, const std::string& path) {
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool TruncateCheckpointFile(const std::string& path, std::uint64_t size) {
+    return truncate(path.c_str(), static_cast<off_t>(size)) == 0;
+}
+
+void WarnCheckpointFailed(const std::string& path) {
+    std::cerr << "warning: could not write checkpoint " << path << std::endl;
+}
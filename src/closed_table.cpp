@@ -0,0 +1,69 @@
+#include "closed_table.h"
+
+#include <cstring>
+
+namespace {
+
+std::size_t SlotCountFor(std::size_t expected) {
+    // Keep the load factor at or below one half.
+    std::size_t slots = 16;
+    while (slots < 2 * expected) slots *= 2;
+    return slots;
+}
+
+} // namespace
+
+ClosedTable::ClosedTable(std::size_t expected)
+    : slots(SlotCountFor(expected), Slot{0, nullptr}), mask(slots.size() - 1) {}
+
+/// Eight discs at a time through the splitmix64 finalizer.
+std::uint64_t ClosedTable::HashOf(const State& s) {
+    const std::size_t size = s.small.size();
+    const Disk* data = s.small.data();
+
+    std::uint64_t h = size;
+    for (std::size_t i = 0; i < size; i += 8) {
+        std::uint64_t w = 0;
+        std::memcpy(&w, data + i, size - i < 8 ? size - i : 8);
+        w += 0x9e3779b97f4a7c15ULL + h;
+        w = (w ^ (w >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        w = (w ^ (w >> 27)) * 0x94d049bb133111ebULL;
+        h = w ^ (w >> 31);
+    }
+    return h;
+}
+
+Node* ClosedTable::Find(const State& s, std::uint64_t hash) const {
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.node == nullptr) return nullptr;
+        if (slot.hash == hash && slot.node->state == s) return slot.node;
+    }
+}
+
+void ClosedTable::Insert(Node* node, std::uint64_t hash) {
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.node == nullptr) {
+            slot = Slot{hash, node};
+            if (++count * 2 > slots.size()) Grow();
+            return;
+        }
+        if (slot.hash == hash && slot.node->state == node->state) {
+            slot.node = node;
+            return;
+        }
+    }
+}
+
+void ClosedTable::Grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{0, nullptr});
+    old.swap(slots);
+    mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.node == nullptr) continue;
+        std::size_t i = slot.hash & mask;
+        while (slots[i].node != nullptr) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
@@ -0,0 +1,62 @@
+#include "exact_distances.h"
+#include "group_size.h"
+#include "move_table.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+State MakeGoalState(std::uint32_t zeroIndex, int n) {
+    const std::uint32_t total = RingSize(n);
+
+    State goal;
+    goal.small.assign(total, 0);
+    goal.zeroIndex = zeroIndex;
+    for (std::uint32_t i = 0; i + 1 < total; ++i) {
+        goal.small[(zeroIndex + 1 + i) % total] = static_cast<Disk>(i / n + 1);
+    }
+    return goal;
+}
+
+std::unordered_map<State, int, StateHash> ComputeExactDistances(const Problem& p) {
+    return ComputeExactDistances(p, std::numeric_limits<int>::max(), 0);
+}
+
+std::unordered_map<State, int, StateHash> ComputeExactDistances(const Problem& p, int maxDepth, std::size_t maxStates) {
+    const std::uint32_t total = static_cast<std::uint32_t>(p.large.size());
+    const MoveTable<kDynamicGroupSize> moves(p);
+
+    // Reverse the move table: sources[z] lists every blank position t that can
+    // move the blank to z, i.e. every possible previous blank position.
+    std::vector<std::vector<std::uint32_t>> sources(total);
+    for (std::uint32_t t = 0; t < total; ++t) {
+        for (std::uint32_t i = 0; i < moves[t].count; ++i) {
+            sources[moves[t].to[i]].push_back(t);
+        }
+    }
+
+    std::unordered_map<State, int, StateHash> distances;
+    std::vector<State> layer, nextLayer;
+    for (std::uint32_t rotation = 0; rotation < total; ++rotation) {
+        State goal = MakeGoalState(rotation, p.n);
+        if (distances.emplace(goal, 0).second) layer.push_back(goal);
+    }
+
+    for (int depth = 1; depth <= maxDepth && !layer.empty(); ++depth) {
+        if (maxStates != 0 && distances.size() >= maxStates) break;
+
+        nextLayer.clear();
+        for (const State& current : layer) {
+            // Undo a move: the disc that slid from `z` into `t` goes back to `z`
+            // and the blank returns to `t`.
+            for (std::uint32_t t : sources[current.zeroIndex]) {
+                State previous = current;
+                ApplyBlankMove(previous, t);
+                if (distances.emplace(previous, depth).second) nextLayer.push_back(previous);
+            }
+        }
+        layer.swap(nextLayer);
+    }
+
+    return distances;
+}
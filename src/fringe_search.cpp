@@ -0,0 +1,183 @@
+#include "fringe_search.h"
+
+#include "packed_state.h"
+#include "solvability.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <unordered_map>
+
+namespace {
+
+struct Record;
+using Fringe = std::list<Record *>;
+
+// Cache entry for one generated state.
+struct Record {
+    State state;
+    int g;
+    int h;
+    Record *parent;
+    Fringe::iterator position; // valid while onFringe
+    bool onFringe;
+};
+
+} // namespace
+
+template <typename HeuristicT, int N>
+FringeSearch<HeuristicT, N>::FringeSearch(const Problem &p, HeuristicT &h, const SearchLimits &l, TraceRecorder *r)
+    : problem(p), heuristic(h), moves(p), limits(l), recorder(r) {
+    heuristic.initialize(problem);
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> FringeSearch<HeuristicT, N>::solve(bool debug) {
+    searchStats = SearchStats();
+    stop = StopReason::None;
+
+    const Solvability solvability = AnalyzeSolvability(problem);
+    if (debug) {
+        std::cout << "[Fringe] pre-check: " << ToString(solvability) << std::endl;
+    }
+    if (solvability == Solvability::Unsolvable) {
+        return {};
+    }
+
+    const unsigned bitsPerDisk = BitsPerDisk(problem.n);
+    std::deque<Record> records;
+    std::unordered_map<PackedState, Record *, PackedStateHash> cache;
+    Fringe fringe;
+    TraceBuffer trace(recorder);
+
+    const State &start = problem.smallState;
+    records.push_back(Record{start, 0, heuristic.template Evaluate<N>(start), nullptr, Fringe::iterator(), true});
+    Record *root = &records.back();
+    cache.emplace(PackedState(start, bitsPerDisk), root);
+    root->position = fringe.insert(fringe.end(), root);
+
+    int threshold = root->h;
+    Record *goal = nullptr;
+
+    while (goal == nullptr && !fringe.empty()) {
+        ++searchStats.iterations;
+        int nextThreshold = std::numeric_limits<int>::max();
+        uint64_t passExpanded = 0;
+        trace.RecordBound(threshold);
+
+        for (Fringe::iterator it = fringe.begin(); it != fringe.end();) {
+            Record *r = *it;
+            const int f = r->g + r->h;
+            const uint32_t from = r->parent != nullptr ? r->parent->state.zeroIndex : kTraceNoMove;
+            if (f > threshold) {
+                // Stays on the fringe for a later pass.
+                trace.Record(r->state, r->g, r->h, from, TraceEvent::Pruned);
+                nextThreshold = std::min(nextThreshold, f);
+                ++it;
+                continue;
+            }
+
+            if (r->state.IsGoal<N>(problem.n)) {
+                trace.Record(r->state, r->g, r->h, from, TraceEvent::Goal);
+                goal = r;
+                break;
+            }
+
+            ++passExpanded;
+            stop = limits.Check(++searchStats.expanded);
+            if (stop != StopReason::None) {
+                if (debug) {
+                    std::cout << "[Fringe] stopped (limits exceeded) iters=" << searchStats.iterations
+                              << " cached=" << records.size() << std::endl;
+                }
+                return {};
+            }
+            trace.Record(r->state, r->g, r->h, from, TraceEvent::Expanded);
+
+            // Children go right after `r`, in move-table order, so this pass
+            // visits them next (depth-first, like IDA*).
+            Fringe::iterator insertAt = std::next(it);
+            const BlankMoves &m = moves[r->state.zeroIndex];
+            for (uint32_t i = 0; i < m.count; ++i) {
+                State child = r->state;
+                ApplyBlankMove(child, m.to[i]);
+                ++searchStats.generated;
+                const int g = r->g + 1;
+
+                PackedState key(child, bitsPerDisk);
+                auto found = cache.find(key);
+                Record *c;
+                if (found != cache.end()) {
+                    c = found->second;
+                    if (g >= c->g) {
+                        trace.Record(c->state, g, c->h, r->state.zeroIndex, TraceEvent::Duplicate);
+                        continue;
+                    }
+                    trace.Record(c->state, g, c->h, r->state.zeroIndex, TraceEvent::Reopened);
+                    // Cheaper path: move it here from wherever it was.
+                    if (c->onFringe) {
+                        if (c->position == insertAt) ++insertAt;
+                        fringe.erase(c->position);
+                    }
+                    c->g = g;
+                    c->parent = r;
+                } else {
+                    const int h = heuristic.template Evaluate<N>(child);
+                    records.push_back(Record{std::move(child), g, h, r, Fringe::iterator(), false});
+                    c = &records.back();
+                    cache.emplace(std::move(key), c);
+                }
+                c->position = fringe.insert(insertAt, c);
+                c->onFringe = true;
+            }
+
+            r->onFringe = false;
+            it = fringe.erase(it);
+        }
+
+        if (debug) {
+            std::cout << "[Fringe] iter=" << searchStats.iterations - 1
+                      << " threshold=" << threshold
+                      << " expanded=" << passExpanded
+                      << " fringe=" << fringe.size()
+                      << " cached=" << records.size()
+                      << std::endl;
+        }
+
+        if (goal == nullptr) {
+            if (nextThreshold == std::numeric_limits<int>::max()) break;
+            threshold = nextThreshold;
+        }
+    }
+
+    if (goal == nullptr) {
+        if (debug) {
+            std::cout << "[Fringe] no solution cached=" << records.size() << std::endl;
+        }
+        return {};
+    }
+
+    std::vector<State> solution;
+    for (const Record *r = goal; r != nullptr; r = r->parent) {
+        solution.push_back(r->state);
+    }
+    std::reverse(solution.begin(), solution.end());
+    if (debug) {
+        std::cout << "[Fringe] solved cost=" << solution.size() - 1
+                  << " total_expanded=" << searchStats.expanded
+                  << " cached=" << records.size() << std::endl;
+    }
+    return solution;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> FringeSearch<HeuristicT, N>::solve() {
+    return solve(false);
+}
+
+#define INSTANTIATE_FRINGE_SEARCH(H) AB_INSTANTIATE_FOR_GROUP_SIZES(FringeSearch, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_FRINGE_SEARCH)
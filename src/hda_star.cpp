@@ -0,0 +1,352 @@
+#include "hda_star.h"
+
+#include "mpsc_queue.h"
+#include "packed_state.h"
+#include "solvability.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// A state owned by one worker. `state` and `h` never change once the record
+// is published; `g` and `parent` are only touched by the owner.
+struct Record {
+    State state;
+    int g;
+    int h;
+    const Record *parent;
+};
+
+// A generated child on its way to its owner.
+struct Message {
+    PackedState key;
+    State state;
+    int g;
+    int h;
+    const Record *parent;
+};
+
+struct OpenEntry {
+    int f;
+    int g;
+    Record *record;
+};
+
+// Lowest f first; among equal f the deeper node, which reaches goals sooner.
+struct OpenOrder {
+    bool operator()(const OpenEntry &a, const OpenEntry &b) const {
+        return a.f != b.f ? a.f > b.f : a.g < b.g;
+    }
+};
+
+// Children sent to one worker are queued locally until a batch is this big...
+constexpr std::size_t kBatchSize = 64;
+// ...or this many expansions have passed, so idle workers are not starved.
+constexpr std::uint32_t kFlushInterval = 128;
+
+constexpr int kNoSolution = std::numeric_limits<int>::max();
+
+// State shared by all workers of one solve.
+struct Shared {
+    explicit Shared(unsigned workers) : inboxes(workers) {}
+
+    std::vector<MpscBatchQueue<Message>> inboxes;
+
+    // Active workers plus messages pushed but not yet taken in. Zero means
+    // the search is over: nobody can generate work any more.
+    std::atomic<std::int64_t> activeWork{0};
+
+    // Cost of the best solution found so far (U) and its goal record.
+    std::atomic<int> bestCost{kNoSolution};
+    std::mutex goalMutex;
+    const Record *goal = nullptr;
+
+    std::atomic<std::uint64_t> expanded{0}; // in steps of kLimitCheckInterval
+    std::atomic<bool> stopping{false};
+    std::atomic<int> stopReason{static_cast<int>(StopReason::None)};
+
+    void Stop(StopReason why) {
+        int none = static_cast<int>(StopReason::None);
+        stopReason.compare_exchange_strong(none, static_cast<int>(why));
+        stopping.store(true);
+    }
+};
+
+template <typename HeuristicT, int N>
+class Worker {
+    const unsigned id;
+    const unsigned workerCount;
+    Shared &shared;
+    const Problem &problem;
+    const HeuristicT &heuristic;
+    const MoveTable<N> &moves;
+    const SearchLimits &limits;
+    const unsigned bitsPerDisk;
+
+    std::deque<Record> records;
+    std::unordered_map<PackedState, Record *, PackedStateHash> table;
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenOrder> open;
+    std::vector<std::vector<Message>> outbox;
+    std::vector<std::vector<Message>> received;
+    std::uint32_t sinceCheck = 0;
+    TraceBuffer trace;
+
+    static std::uint32_t BlankOf(const Record *r) { return r != nullptr ? r->state.zeroIndex : kTraceNoMove; }
+
+  public:
+    SearchStats stats;
+
+    Worker(unsigned workerId, Shared &s, const Problem &p, const HeuristicT &h, const MoveTable<N> &m,
+           const SearchLimits &l, TraceRecorder *recorder)
+        : id(workerId), workerCount(static_cast<unsigned>(s.inboxes.size())), shared(s), problem(p), heuristic(h),
+          moves(m), limits(l), bitsPerDisk(BitsPerDisk(p.n)), outbox(s.inboxes.size()), trace(recorder, workerId) {}
+
+    static unsigned Owner(const PackedState &key, unsigned workers) {
+        // The closed table hashes the same key; mix the high bits in so the
+        // two do not bucket alike.
+        const std::uint64_t h = key.Hash();
+        return static_cast<unsigned>((h ^ (h >> 32)) % workers);
+    }
+
+    void Run() {
+        std::uint32_t sinceFlush = 0;
+        while (!shared.stopping.load(std::memory_order_relaxed)) {
+            Drain();
+            if (ExpandNext()) {
+                if (++sinceFlush == kFlushInterval) {
+                    FlushAll();
+                    sinceFlush = 0;
+                }
+                continue;
+            }
+
+            // Nothing below U left here: hand off what we generated and wait.
+            FlushAll();
+            sinceFlush = 0;
+            if (!shared.inboxes[id].Empty()) continue;
+
+            shared.activeWork.fetch_sub(1);
+            while (true) {
+                if (!shared.inboxes[id].Empty()) {
+                    // The pending message keeps the counter above zero until Drain().
+                    shared.activeWork.fetch_add(1);
+                    break;
+                }
+                if (shared.activeWork.load() == 0 || shared.stopping.load(std::memory_order_relaxed)) return;
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Take in a child (from this worker or another). Keeps only the cheapest
+    // path to each state; an improved g reopens the state.
+    void Receive(Message &&m) {
+        auto it = table.find(m.key);
+        if (it != table.end()) {
+            Record *r = it->second;
+            if (m.g >= r->g) {
+                trace.Record(r->state, m.g, r->h, BlankOf(m.parent), TraceEvent::Duplicate);
+                return;
+            }
+            trace.Record(r->state, m.g, r->h, BlankOf(m.parent), TraceEvent::Reopened);
+            r->g = m.g;
+            r->parent = m.parent;
+            open.push(OpenEntry{m.g + r->h, m.g, r});
+            return;
+        }
+
+        records.push_back(Record{std::move(m.state), m.g, m.h, m.parent});
+        Record *r = &records.back();
+        table.emplace(std::move(m.key), r);
+        open.push(OpenEntry{r->g + r->h, r->g, r});
+    }
+
+  private:
+    void Drain() {
+        if (shared.inboxes[id].Empty()) return;
+        received.clear();
+        const std::size_t count = shared.inboxes[id].PopAll(received);
+        for (std::vector<Message> &batch : received) {
+            for (Message &m : batch) Receive(std::move(m));
+        }
+        shared.activeWork.fetch_sub(static_cast<std::int64_t>(count));
+    }
+
+    void Send(unsigned to, Message &&m) {
+        outbox[to].push_back(std::move(m));
+        if (outbox[to].size() >= kBatchSize) Flush(to);
+    }
+
+    void Flush(unsigned to) {
+        if (outbox[to].empty()) return;
+        shared.activeWork.fetch_add(static_cast<std::int64_t>(outbox[to].size()));
+        shared.inboxes[to].Push(std::move(outbox[to]));
+        outbox[to] = std::vector<Message>();
+        outbox[to].reserve(kBatchSize);
+    }
+
+    void FlushAll() {
+        for (unsigned to = 0; to < workerCount; ++to) Flush(to);
+    }
+
+    void CheckLimits() {
+        if (++sinceCheck < kLimitCheckInterval) return;
+        sinceCheck = 0;
+        const std::uint64_t total = shared.expanded.fetch_add(kLimitCheckInterval) + kLimitCheckInterval;
+        const StopReason why = limits.Check(total);
+        if (why != StopReason::None) shared.Stop(why);
+    }
+
+    // Expand the best open node below U. False if there is none.
+    bool ExpandNext() {
+        while (!open.empty()) {
+            const OpenEntry entry = open.top();
+            if (entry.f >= shared.bestCost.load(std::memory_order_relaxed)) {
+                // Everything left is at least as expensive as a known solution.
+                open = decltype(open)();
+                return false;
+            }
+            open.pop();
+
+            Record *r = entry.record;
+            if (entry.g != r->g) continue; // superseded by a cheaper path
+
+            if (r->state.IsGoal<N>(problem.n)) {
+                trace.Record(r->state, r->g, r->h, BlankOf(r->parent), TraceEvent::Goal);
+                std::lock_guard<std::mutex> lock(shared.goalMutex);
+                if (r->g < shared.bestCost.load()) {
+                    shared.bestCost.store(r->g);
+                    shared.goal = r;
+                }
+                continue;
+            }
+
+            ++stats.expanded;
+            CheckLimits();
+            trace.Record(r->state, r->g, r->h, BlankOf(r->parent), TraceEvent::Expanded);
+
+            const BlankMoves &m = moves[r->state.zeroIndex];
+            for (std::uint32_t i = 0; i < m.count; ++i) {
+                State child = r->state;
+                ApplyBlankMove(child, m.to[i]);
+                if (r->parent != nullptr && r->parent->state.zeroIndex == child.zeroIndex &&
+                    r->parent->state == child) {
+                    continue; // straight back to where we came from
+                }
+
+                const int g = r->g + 1;
+                const int h = heuristic.template Evaluate<N>(child);
+                ++stats.generated;
+                if (g + h >= shared.bestCost.load(std::memory_order_relaxed)) {
+                    trace.Record(child, g, h, r->state.zeroIndex, TraceEvent::Pruned);
+                    continue;
+                }
+
+                PackedState key(child, bitsPerDisk);
+                const unsigned owner = Owner(key, workerCount);
+                Message msg{std::move(key), std::move(child), g, h, r};
+                if (owner == id) {
+                    Receive(std::move(msg));
+                } else {
+                    Send(owner, std::move(msg));
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+template <typename HeuristicT, int N>
+HDAStar<HeuristicT, N>::HDAStar(const Problem &p, HeuristicT &h, const SearchLimits &l, unsigned t,
+                                TraceRecorder *r)
+    : problem(p), heuristic(h), moves(p), limits(l), threads(t), recorder(r) {
+    heuristic.initialize(problem);
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> HDAStar<HeuristicT, N>::solve(bool debug) {
+    searchStats = SearchStats();
+    searchStats.iterations = 1;
+    stop = StopReason::None;
+
+    const Solvability solvability = AnalyzeSolvability(problem);
+    if (debug) {
+        std::cout << "[HDA*] pre-check: " << ToString(solvability) << " workers=" << threads << std::endl;
+    }
+    if (solvability == Solvability::Unsolvable) {
+        return {};
+    }
+
+    Shared shared(threads);
+    std::vector<std::unique_ptr<Worker<HeuristicT, N>>> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(new Worker<HeuristicT, N>(i, shared, problem, heuristic, moves, limits, recorder));
+    }
+
+    // Hand the start state to its owner before anyone runs.
+    const State &start = problem.smallState;
+    PackedState startKey(start, BitsPerDisk(problem.n));
+    const unsigned owner = Worker<HeuristicT, N>::Owner(startKey, threads);
+    workers[owner]->Receive(Message{std::move(startKey), start, 0, heuristic.template Evaluate<N>(start), nullptr});
+    shared.activeWork.store(threads);
+
+    std::vector<std::thread> running;
+    for (unsigned i = 1; i < threads; ++i) {
+        running.emplace_back([&workers, i] { workers[i]->Run(); });
+    }
+    workers[0]->Run();
+    for (std::thread &t : running) t.join();
+
+    for (unsigned i = 0; i < threads; ++i) {
+        searchStats.expanded += workers[i]->stats.expanded;
+        searchStats.generated += workers[i]->stats.generated;
+        if (debug) {
+            std::cout << "[HDA*] worker " << i << " expanded=" << workers[i]->stats.expanded << std::endl;
+        }
+    }
+
+    stop = static_cast<StopReason>(shared.stopReason.load());
+    if (stop != StopReason::None) {
+        if (debug) {
+            std::cout << "[HDA*] stopped (limits exceeded) expanded=" << searchStats.expanded << std::endl;
+        }
+        return {};
+    }
+    if (shared.goal == nullptr) {
+        return {};
+    }
+
+    // Parents were last written by their owners before the join above.
+    std::vector<State> solution;
+    for (const Record *r = shared.goal; r != nullptr; r = r->parent) {
+        solution.push_back(r->state);
+    }
+    std::reverse(solution.begin(), solution.end());
+    if (debug) {
+        std::cout << "[HDA*] solved cost=" << solution.size() - 1 << " expanded=" << searchStats.expanded << std::endl;
+    }
+    return solution;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> HDAStar<HeuristicT, N>::solve() {
+    return solve(false);
+}
+
+#define INSTANTIATE_HDA_STAR(H) AB_INSTANTIATE_FOR_GROUP_SIZES(HDAStar, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_HDA_STAR)
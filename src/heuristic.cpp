@@ -1,12 +1,12 @@
 #include "heuristic.h"
-#include "util.h"
+#include "perf_counters.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
-#include <queue>
 #include <utility>
 #include <vector>
 
@@ -28,17 +28,20 @@ uint32_t InferGroupSizeFromState(const State& s) {
 
 // Count how many discs are misplaced if we treat `startIdx` as the reference
 // index (ie. the position of zero is at `startIdx` for the purpose of rotation).
+// With a static N the ring size and group size are compile-time constants.
+template <int N = kDynamicGroupSize>
 uint32_t MisplacedDiscCountForRotation(const State& s, uint32_t startIdx, uint32_t groupSize) {
-    const std::size_t total = s.small.size();
+    const std::size_t total = Ring<N>::Size(s.small);
+    const uint32_t group = static_cast<uint32_t>(Ring<N>::Group(static_cast<int>(groupSize)));
     assert(total > 0);
-    assert(groupSize > 0);
+    assert(group > 0);
 
-    const uint32_t goalCount = groupSize * groupSize; // number of non-zero discs
+    const uint32_t goalCount = group * group; // number of non-zero discs
     uint32_t misplaced = 0;
 
     for (uint32_t i = 0; i < goalCount; ++i) {
         const uint32_t index = static_cast<uint32_t>((static_cast<std::size_t>(startIdx) + 1 + i) % total);
-        const uint32_t expected = (i / groupSize) + 1;
+        const uint32_t expected = (i / group) + 1;
         if (s.small[index] != expected) {
             ++misplaced;
         }
@@ -47,63 +50,156 @@ uint32_t MisplacedDiscCountForRotation(const State& s, uint32_t startIdx, uint32
     return misplaced;
 }
 
-struct DiskMoves {
-    std::size_t neighbors[4];
-};
+// Offset of `colour`'s first goal slot from the goal blank.
+uint32_t GoalSegmentOffset(uint32_t colour, uint32_t groupSize) {
+    return 1 + (colour - 1) * groupSize;
+}
 
-void CreateHopMatrix(std::vector<std::vector<int>>& matrix, const Problem& p) {
-    const std::size_t n = p.large.size(); // number of positions/disks
-    matrix.assign(n, std::vector<int>(n, 0));
+// First goal slot of `colour` when the goal blank sits at `rotation`.
+uint32_t GoalSegmentStart(uint32_t colour, uint32_t rotation, uint32_t groupSize, uint32_t total) {
+    return (rotation + GoalSegmentOffset(colour, groupSize)) % total;
+}
 
-    std::vector<DiskMoves> moves(n);
-    for (std::size_t i = 0; i < moves.size(); ++i) {
-        const Disk large = p.large[i];
-        moves[i] = DiskMoves{
-            static_cast<std::size_t>(WrapIndex(static_cast<int>(i) - 1, static_cast<int>(n))),
-            static_cast<std::size_t>(WrapIndex(static_cast<int>(i) + 1, static_cast<int>(n))),
-            static_cast<std::size_t>(WrapIndex(static_cast<int>(i) - static_cast<int>(large), static_cast<int>(n))),
-            static_cast<std::size_t>(WrapIndex(static_cast<int>(i) + static_cast<int>(large), static_cast<int>(n))),
-        };
+// rotationH[r] += segmentRow[(r + offset) % total] for every rotation r: the
+// segment row of a disc, seen from the goal blank of each rotation. Segment
+// rows repeat after `total` entries, so no wrap is needed.
+template <typename IntArray>
+void AddRotatedSegmentRow(IntArray& rotationH, const HopTable::Hops* segmentRow, uint32_t offset, uint32_t total) {
+    const HopTable::Hops* shifted = segmentRow + offset;
+    for (uint32_t rotation = 0; rotation < total; ++rotation) {
+        rotationH[rotation] += shifted[rotation];
     }
+}
 
-    // BFS from each start position to compute shortest hop distances.
-    for (std::size_t startPos = 0; startPos < moves.size(); ++startPos) {
-        std::queue<std::pair<std::size_t, int>> q;
-        std::vector<bool> visited(n, false);
-
-        q.push({startPos, 0});
-        visited[startPos] = true;
-        matrix[startPos][startPos] = 0;
-
-        while (!q.empty()) {
-            const auto current = q.front();
-            q.pop();
-
-            const std::size_t curr = current.first;
-            const int cost = current.second;
+// Cost of the cheapest one-to-one assignment of k discs to k slots, where
+// cost[i * k + j] is the number of hops for disc i to reach slot j.
+// Hungarian algorithm (shortest augmenting paths with potentials), O(k^3).
+template <int N>
+int MinAssignmentCost(const int* cost, int k) {
+    using IntArray = typename Ring<N>::template Array<int>;
+    const uint32_t size = static_cast<uint32_t>(k + 1);
+
+    IntArray u, v, match, way, minv, used;
+    Ring<N>::Resize(u, size);
+    Ring<N>::Resize(v, size);
+    Ring<N>::Resize(match, size);
+    Ring<N>::Resize(way, size);
+    Ring<N>::Resize(minv, size);
+    Ring<N>::Resize(used, size);
+    std::fill(u.begin(), u.end(), 0);
+    std::fill(v.begin(), v.end(), 0);
+    std::fill(match.begin(), match.end(), 0);
+
+    // Rows and columns are 1-based; column 0 is the augmenting path's root.
+    for (int row = 1; row <= k; ++row) {
+        match[0] = row;
+        int col0 = 0;
+        std::fill(minv.begin(), minv.end(), std::numeric_limits<int>::max());
+        std::fill(used.begin(), used.end(), 0);
+
+        do {
+            used[col0] = 1;
+            const int row0 = match[col0];
+            int delta = std::numeric_limits<int>::max();
+            int col1 = 0;
+
+            for (int col = 1; col <= k; ++col) {
+                if (used[col]) continue;
+                const int reduced = cost[(row0 - 1) * k + (col - 1)] - u[row0] - v[col];
+                if (reduced < minv[col]) {
+                    minv[col] = reduced;
+                    way[col] = col0;
+                }
+                if (minv[col] < delta) {
+                    delta = minv[col];
+                    col1 = col;
+                }
+            }
 
-            for (std::size_t neighbor : moves[curr].neighbors) {
-                if (!visited[neighbor]) {
-                    visited[neighbor] = true;
-                    matrix[startPos][neighbor] = cost + 1;
-                    q.push({neighbor, cost + 1});
+            for (int col = 0; col <= k; ++col) {
+                if (used[col]) {
+                    u[match[col]] += delta;
+                    v[col] -= delta;
+                } else {
+                    minv[col] -= delta;
                 }
             }
-        }
+            col0 = col1;
+        } while (match[col0] != 0);
+
+        do {
+            const int col1 = way[col0];
+            match[col0] = match[col1];
+            col0 = col1;
+        } while (col0 != 0);
     }
+
+    return -v[0];
 }
 
-void GetGoalPositions(std::vector<int>& goals, Disk disk, int zeroIndex, int groupSize) {
-    assert(static_cast<int>(goals.size()) == groupSize);
-    assert(groupSize > 0);
+// Fewest total hops to move the discs of one colour onto distinct goal slots.
+// With exact distances a disc already sitting on one of its slots keeps it in
+// some optimal assignment (hop distances obey the triangle inequality), so
+// only displaced discs and free slots go into the assignment problem. Block
+// lower bounds do not obey it, so then every disc is assigned.
+template <int N>
+int ColourAssignmentCost(const HopTable& hops,
+                         const uint32_t* discs,
+                         uint32_t segmentStart,
+                         uint32_t groupSize,
+                         uint32_t total) {
+    using PosArray = typename Ring<N>::template Array<uint32_t>;
+    PosArray from, to, taken;
+    Ring<N>::Resize(from, total);
+    Ring<N>::Resize(to, total);
+    Ring<N>::Resize(taken, total);
+    std::fill(taken.begin(), taken.begin() + groupSize, 0);
+
+    int displaced = 0;
+    for (uint32_t i = 0; i < groupSize; ++i) {
+        const uint32_t offset = (discs[i] + total - segmentStart) % total;
+        if (offset < groupSize && hops.IsExact()) {
+            taken[offset] = 1;
+        } else {
+            from[displaced++] = discs[i];
+        }
+    }
+    if (displaced == 0) return 0;
 
-    const int total = groupSize * groupSize + 1;                     // total positions
-    const int startIndex = groupSize * (static_cast<int>(disk) - 1); // start of disk's goal group (unrotated)
+    int freeSlots = 0;
+    for (uint32_t offset = 0; offset < groupSize; ++offset) {
+        if (!taken[offset]) to[freeSlots++] = (segmentStart + offset) % total;
+    }
+    assert(freeSlots == displaced);
+
+    if (displaced == 1) return hops.DiscToSlot(from[0], to[0]);
 
-    for (int i = 0; i < groupSize; ++i) {
-        const int index = (zeroIndex + 1 + startIndex + i) % total;
-        goals[i] = index;
+    // displaced^2 <= groupSize^2 < total, so a ring-sized buffer holds the matrix.
+    typename Ring<N>::template Array<int> cost;
+    Ring<N>::Resize(cost, total);
+    for (int i = 0; i < displaced; ++i) {
+        for (int j = 0; j < displaced; ++j) {
+            cost[i * displaced + j] = hops.DiscToSlot(from[i], to[j]);
+        }
     }
+    return MinAssignmentCost<N>(&cost[0], displaced);
+}
+
+// True if a disc of `colour` moving from `from` into the blank at `to` gets
+// strictly closer to at least one of its goal slots under `rotation`.
+bool CanProgress(const HopTable& hops,
+                 Disk colour,
+                 uint32_t from,
+                 uint32_t to,
+                 uint32_t rotation,
+                 uint32_t groupSize,
+                 uint32_t total) {
+    uint32_t slot = GoalSegmentStart(colour, rotation, groupSize, total);
+    for (uint32_t i = 0; i < groupSize; ++i) {
+        if (hops.DiscToSlot(to, slot) < hops.DiscToSlot(from, slot)) return true;
+        if (++slot == total) slot = 0;
+    }
+    return false;
 }
 
 } // namespace
@@ -113,54 +209,200 @@ uint32_t MisplacedDiscCount(const State& s, uint32_t startIdx, uint32_t n) {
     return MisplacedDiscCountForRotation(s, startIdx, n);
 }
 
+void MisplacedDiscHeuristic::initialize(const Problem& p) {
+    if (groupSize == p.n) return;
+    groupSize = p.n;
+}
+
 int MisplacedDiscHeuristic::operator()(const State& s) const {
-    const uint32_t groupSize = InferGroupSizeFromState(s);
-    assert(groupSize != 0);
+    return Evaluate<kDynamicGroupSize>(s);
+}
+
+template <int N>
+int MisplacedDiscHeuristic::Evaluate(const State& s) const {
+    // Only the uninitialized generic path still has to recover n from the state.
+    const uint32_t group = N != kDynamicGroupSize ? static_cast<uint32_t>(N)
+                         : groupSize != 0         ? static_cast<uint32_t>(groupSize)
+                                                  : InferGroupSizeFromState(s);
+    assert(group != 0);
 
+    const uint32_t total = Ring<N>::Size(s.small);
     uint32_t best = std::numeric_limits<uint32_t>::max();
-    for (uint32_t i = 0; i < s.small.size(); ++i) {
-        const uint32_t count = MisplacedDiscCountForRotation(s, i, groupSize);
+    for (uint32_t i = 0; i < total; ++i) {
+        const uint32_t count = MisplacedDiscCountForRotation<N>(s, i, group);
         if (count < best) best = count;
     }
     return static_cast<int>(best);
 }
 
 int HopHeuristic::operator()(const State& s) const {
-    const int total = static_cast<int>(s.small.size());
-    const uint32_t groupSizeU = InferGroupSizeFromState(s);
-    assert(groupSizeU != 0);
+    return Evaluate<kDynamicGroupSize>(s);
+}
 
-    const int groupSize = static_cast<int>(groupSizeU);
-    std::vector<int> goalPositions(groupSize);
+template <int N>
+int HopHeuristic::Evaluate(const State& s) const {
+    typename Ring<N>::template Array<int> rotationH;
+    EvaluateRotations<N>(s, rotationH);
+    return *std::min_element(rotationH.begin(), rotationH.end());
+}
 
-    int bestH = std::numeric_limits<int>::max();
+template <int N>
+void HopHeuristic::EvaluateRotations(const State& s, typename Ring<N>::template Array<int>& rotationH) const {
+    const uint32_t total = Ring<N>::Size(s.small);
+    const uint32_t group = static_cast<uint32_t>(Ring<N>::Group(groupSize));
+    assert(hops.RingSize() == total);
 
-    // Calculate h for every goal-state rotation.
-    for (int zeroRotation = 0; zeroRotation < total; ++zeroRotation) {
-        int rotationH = 0;
+    // h for every goal-state rotation at once: each disc adds its segment
+    // row (one entry per rotation) to the running totals.
+    Ring<N>::Resize(rotationH, total);
+    std::fill(rotationH.begin(), rotationH.end(), 0);
 
-        // For each disc, add the min hops to any of its goal positions.
-        for (int start = 0; start < total; ++start) {
-            const Disk disk = s.small[static_cast<std::size_t>(start)];
-            if (disk == 0) continue;
+    // Only block lower bounds (large rings, never a static N) need a row buffer.
+    std::vector<HopTable::Hops> scratch(hops.IsExact() ? 0 : 2 * total);
 
-            GetGoalPositions(goalPositions, disk, zeroRotation, groupSize);
+    for (uint32_t start = 0; start < total; ++start) {
+        const Disk disk = s.small[start];
+        if (disk == 0) continue;
 
-            int leastNumHops = std::numeric_limits<int>::max();
-            for (int dest : goalPositions) {
-                const int hops = hopMatrix[static_cast<std::size_t>(start)][static_cast<std::size_t>(dest)];
-                if (hops < leastNumHops) leastNumHops = hops;
-            }
+        AddRotatedSegmentRow(rotationH, hops.SegmentRow(start, scratch.data()), GoalSegmentOffset(disk, group), total);
+    }
+}
+
+void HopHeuristic::initialize(const Problem& p) {
+    if (IsInitializedFor(p)) return;
+    PerfScope scope(PerfPhase::HeuristicInit);
+
+    groupSize = p.n;
+    assert(groupSize > 0 && RingSize(groupSize) == p.large.size());
+    hops.Build(p);
+
+    layout = p.large;
+}
+
+void HopConflictHeuristic::initialize(const Problem& p) {
+    if (IsInitializedFor(p)) return;
+
+    HopHeuristic::initialize(p);
+    blankMoves = MoveTable<kDynamicGroupSize>(p);
+}
+
+int HopConflictHeuristic::operator()(const State& s) const {
+    return Evaluate<kDynamicGroupSize>(s);
+}
 
-            rotationH += leastNumHops;
+// Every move slides one disc by one hop, so for a solution ending in a given
+// rotation the sum over discs of the hops to their final slots drops by at
+// most one per move. Hence the solution length is at least
+//   (cheapest assignment of discs to their colour's slots)
+//   + (number of moves that bring no disc closer to any of its slots).
+// The second term is bounded by looking two moves ahead from the blank.
+// The blank's own distance to the rotation's blank position is a separate
+// lower bound, so h for a rotation is the larger of the two.
+template <int N>
+int HopConflictHeuristic::Evaluate(const State& s) const {
+    const uint32_t total = Ring<N>::Size(s.small);
+    const uint32_t group = static_cast<uint32_t>(Ring<N>::Group(groupSize));
+    const uint32_t zero = s.zeroIndex;
+    assert(hops.RingSize() == total);
+
+    // Independent hop sums (HopHeuristic) for every rotation.
+    typename Ring<N>::template Array<int> rotationH;
+    Ring<N>::Resize(rotationH, total);
+    std::fill(rotationH.begin(), rotationH.end(), 0);
+
+    // Disc positions grouped by colour: colour c fills [(c - 1) * group, c * group).
+    typename Ring<N>::template Array<uint32_t> discs, filled;
+    Ring<N>::Resize(discs, total);
+    Ring<N>::Resize(filled, total);
+    std::fill(filled.begin(), filled.end(), 0);
+
+    // Only block lower bounds (large rings, never a static N) need a row buffer.
+    std::vector<HopTable::Hops> scratch(hops.IsExact() ? 0 : 2 * total);
+
+    for (uint32_t start = 0; start < total; ++start) {
+        const Disk disk = s.small[start];
+        if (disk == 0) continue;
+
+        AddRotatedSegmentRow(rotationH, hops.SegmentRow(start, scratch.data()), GoalSegmentOffset(disk, group), total);
+        discs[(disk - 1) * group + filled[disk - 1]++] = start;
+    }
+
+    // The penalties only ever add to a rotation's hop sum, so visit rotations
+    // cheapest first and stop once a hop sum alone cannot beat the best bound.
+    typename Ring<N>::template Array<uint32_t> order;
+    Ring<N>::Resize(order, total);
+    for (uint32_t i = 0; i < total; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return rotationH[a] != rotationH[b] ? rotationH[a] < rotationH[b] : a < b;
+    });
+
+    int bestH = std::numeric_limits<int>::max();
+    for (uint32_t i = 0; i < total; ++i) {
+        const uint32_t rotation = order[i];
+        if (rotationH[rotation] >= bestH) break;
+
+        int h = 0;
+        for (uint32_t colour = 1; colour <= group; ++colour) {
+            h += ColourAssignmentCost<N>(hops, &discs[(colour - 1) * group],
+                                         GoalSegmentStart(colour, rotation, group, total), group, total);
         }
 
-        if (rotationH < bestH) bestH = rotationH;
+        if (h > 0) {
+            h += BlankTravelPenalty(s, rotation);
+        }
+
+        h = std::max(h, hops.DiscToSlot(rotation, zero)); // the blank travelling zero -> rotation
+        if (h < bestH) bestH = h;
     }
 
     return bestH;
 }
 
-void HopHeuristic::initialize(const Problem& p) {
-    CreateHopMatrix(hopMatrix, p);
+// Moves before the blank can pull some disc closer to one of its goal slots,
+// looking at most two moves ahead (0, 1 or 2). Only valid for non-goal states.
+int HopConflictHeuristic::BlankTravelPenalty(const State& s, uint32_t rotation) const {
+    const uint32_t total = static_cast<uint32_t>(s.small.size());
+    const uint32_t group = static_cast<uint32_t>(groupSize);
+    const uint32_t zero = s.zeroIndex;
+
+    const BlankMoves& first = blankMoves[zero];
+    for (uint32_t i = 0; i < first.count; ++i) {
+        const uint32_t from = first.to[i];
+        if (CanProgress(hops, s.small[from], from, zero, rotation, group, total)) return 0;
+    }
+
+    // After the first move the blank is at `next` and the disc from `next` sits at `zero`.
+    for (uint32_t i = 0; i < first.count; ++i) {
+        const uint32_t next = first.to[i];
+        const BlankMoves& second = blankMoves[next];
+        for (uint32_t j = 0; j < second.count; ++j) {
+            const uint32_t from = second.to[j];
+            const Disk colour = from == zero ? s.small[next] : s.small[from];
+            if (CanProgress(hops, colour, from, next, rotation, group, total)) return 1;
+        }
+    }
+
+    return 2;
 }
+
+#define INSTANTIATE_EVALUATE(H)                                    \
+    template int H::Evaluate<kDynamicGroupSize>(const State&) const; \
+    template int H::Evaluate<2>(const State&) const;               \
+    template int H::Evaluate<3>(const State&) const;               \
+    template int H::Evaluate<4>(const State&) const;               \
+    template int H::Evaluate<5>(const State&) const;               \
+    template int H::Evaluate<6>(const State&) const;
+
+#define INSTANTIATE_EVALUATE_ROTATIONS(N) \
+    template void HopHeuristic::EvaluateRotations<N>(const State&, Ring<N>::Array<int>&) const;
+
+INSTANTIATE_EVALUATE_ROTATIONS(kDynamicGroupSize)
+INSTANTIATE_EVALUATE_ROTATIONS(2)
+INSTANTIATE_EVALUATE_ROTATIONS(3)
+INSTANTIATE_EVALUATE_ROTATIONS(4)
+INSTANTIATE_EVALUATE_ROTATIONS(5)
+INSTANTIATE_EVALUATE_ROTATIONS(6)
+
+INSTANTIATE_EVALUATE(MisplacedDiscHeuristic)
+INSTANTIATE_EVALUATE(HopHeuristic)
+INSTANTIATE_EVALUATE(HopConflictHeuristic)
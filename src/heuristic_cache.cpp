@@ -0,0 +1,35 @@
+#include "heuristic_cache.h"
+
+HeuristicCache::HeuristicCache(std::size_t cap) : capacity(cap > 0 ? cap : 1) {}
+
+std::shared_ptr<Heuristic> HeuristicCache::Get(HeuristicKind kind, const Problem& p) {
+    std::string key;
+    key.reserve(p.large.size() + 8);
+    key += std::to_string(static_cast<int>(kind));
+    key += ':';
+    key += std::to_string(p.n);
+    key += ':';
+    key.append(p.large.begin(), p.large.end());
+
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<Entry>& slot = entries[key];
+        if (!slot) {
+            slot = std::make_shared<Entry>();
+            insertionOrder.push_back(key);
+        }
+        entry = slot;
+
+        while (insertionOrder.size() > capacity) {
+            entries.erase(insertionOrder.front());
+            insertionOrder.pop_front();
+        }
+    }
+
+    std::call_once(entry->once, [&] {
+        entry->heuristic = MakeHeuristic(kind);
+        entry->heuristic->initialize(p);
+    });
+    return std::shared_ptr<Heuristic>(entry, entry->heuristic.get());
+}
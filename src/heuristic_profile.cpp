@@ -0,0 +1,313 @@
+#include "heuristic_profile.h"
+
+#include "exact_distances.h"
+#include "group_size.h"
+#include "move_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+const HeuristicKind kAllHeuristics[] = {
+    HeuristicKind::Zero,
+    HeuristicKind::MisplacedDisc,
+    HeuristicKind::Hop,
+    HeuristicKind::HopConflict,
+};
+
+// One random walk of `depth` moves from `start` without immediate reversals,
+// like a path of the brute-force tree. weights[i] is the product of the
+// number of moves to choose from on the way to walk[i].
+void RandomWalk(const MoveTable<kDynamicGroupSize>& moves, const State& start, int depth, std::mt19937& rng,
+                std::vector<State>& walk, std::vector<double>& weights) {
+    walk.assign(1, start);
+    weights.assign(1, 1.0);
+    std::uint32_t previous = std::numeric_limits<std::uint32_t>::max();
+    for (int i = 0; i < depth; ++i) {
+        State s = walk.back();
+        const BlankMoves& m = moves[s.zeroIndex];
+        std::uint32_t choices[4];
+        std::uint32_t count = 0;
+        for (std::uint32_t k = 0; k < m.count; ++k) {
+            if (m.to[k] != previous) choices[count++] = m.to[k];
+        }
+        if (count == 0) break;
+
+        previous = s.zeroIndex;
+        ApplyBlankMove(s, choices[std::uniform_int_distribution<std::uint32_t>(0, count - 1)(rng)]);
+        weights.push_back(weights.back() * count);
+        walk.push_back(std::move(s));
+    }
+}
+
+// h of every state through the group-size specialized Evaluate the solvers
+// call; the virtual operator() is several times slower and would skew the timing.
+template <typename HeuristicT>
+void EvaluateAll(const HeuristicT& h, const Problem& p, const State* states, std::size_t count, int* out) {
+    DispatchGroupSize(p.n, p.large.size(), [&](auto groupSize) {
+        constexpr int N = decltype(groupSize)::value;
+        for (std::size_t i = 0; i < count; ++i) out[i] = h.template Evaluate<N>(states[i]);
+    });
+}
+
+void EvaluateAll(const Heuristic& h, HeuristicKind kind, const Problem& p, const State* states, std::size_t count,
+                 int* out) {
+    switch (kind) {
+        case HeuristicKind::Zero:
+            return EvaluateAll(static_cast<const ZeroHeuristic&>(h), p, states, count, out);
+        case HeuristicKind::MisplacedDisc:
+            return EvaluateAll(static_cast<const MisplacedDiscHeuristic&>(h), p, states, count, out);
+        case HeuristicKind::Hop:
+            return EvaluateAll(static_cast<const HopHeuristic&>(h), p, states, count, out);
+        case HeuristicKind::HopConflict:
+            return EvaluateAll(static_cast<const HopConflictHeuristic&>(h), p, states, count, out);
+    }
+    EvaluateAll(h, p, states, count, out);
+}
+
+} // namespace
+
+// A node is identified by the blank's position and where it came from; the
+// tree below it only depends on that pair. counts[z][j] is the number of
+// depth-i nodes with the blank at z that arrived from sources[z][j].
+std::vector<double> BruteForceTreeSizes(const Problem& p, const State& start, int maxDepth) {
+    const std::uint32_t total = static_cast<std::uint32_t>(p.large.size());
+    const MoveTable<kDynamicGroupSize> moves(p);
+
+    // sources[t] lists the blank positions with a move to t; arrival[z][i] is
+    // the index of z in sources[moves[z].to[i]].
+    std::vector<std::vector<std::uint32_t>> sources(total);
+    std::vector<std::vector<std::uint32_t>> arrival(total);
+    for (std::uint32_t z = 0; z < total; ++z) {
+        for (std::uint32_t i = 0; i < moves[z].count; ++i) {
+            const std::uint32_t t = moves[z].to[i];
+            arrival[z].push_back(static_cast<std::uint32_t>(sources[t].size()));
+            sources[t].push_back(z);
+        }
+    }
+
+    std::vector<double> sizes(1, 1.0);
+    std::vector<std::vector<double>> counts(total), next(total);
+    for (std::uint32_t z = 0; z < total; ++z) {
+        counts[z].assign(sources[z].size(), 0.0);
+        next[z].assign(sources[z].size(), 0.0);
+    }
+
+    // Depth 1: every move from the root.
+    const BlankMoves& root = moves[start.zeroIndex];
+    for (std::uint32_t i = 0; i < root.count; ++i) {
+        counts[root.to[i]][arrival[start.zeroIndex][i]] += 1.0;
+    }
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        double layer = 0;
+        for (std::uint32_t z = 0; z < total; ++z) {
+            for (double c : counts[z]) layer += c;
+        }
+        sizes.push_back(layer);
+        if (depth == maxDepth) break;
+
+        for (std::vector<double>& row : next) std::fill(row.begin(), row.end(), 0.0);
+        for (std::uint32_t z = 0; z < total; ++z) {
+            for (std::size_t j = 0; j < counts[z].size(); ++j) {
+                const double c = counts[z][j];
+                if (c == 0) continue;
+                const std::uint32_t previous = sources[z][j];
+                for (std::uint32_t i = 0; i < moves[z].count; ++i) {
+                    const std::uint32_t t = moves[z].to[i];
+                    if (t == previous) continue; // back to the parent's state
+                    next[t][arrival[z][i]] += c;
+                }
+            }
+        }
+        counts.swap(next);
+    }
+    return sizes;
+}
+
+HeuristicProfile ProfileHeuristic(const Problem& p,
+                                  HeuristicKind kind,
+                                  const std::vector<std::vector<State>>& statesByDepth,
+                                  const ProfileOptions& options) {
+    std::unique_ptr<Heuristic> heuristic = MakeHeuristic(kind);
+    heuristic->initialize(p);
+
+    HeuristicProfile profile;
+    profile.kind = kind;
+    profile.startH = (*heuristic)(p.smallState);
+
+    for (std::size_t depth = 0; depth < statesByDepth.size(); ++depth) {
+        HeuristicProfile::Depth d;
+        d.depth = static_cast<int>(depth);
+        d.minH = std::numeric_limits<int>::max();
+
+        double sumH = 0;
+        for (const State& s : statesByDepth[depth]) {
+            const int h = (*heuristic)(s);
+            if (static_cast<std::size_t>(h) >= d.histogram.size()) d.histogram.resize(h + 1, 0);
+            ++d.histogram[h];
+            ++d.states;
+            if (h == d.depth) ++d.exact;
+            if (h > d.depth) ++d.overestimates;
+            d.minH = std::min(d.minH, h);
+            d.maxH = std::max(d.maxH, h);
+            sumH += h;
+        }
+        if (d.states == 0) d.minH = 0;
+        d.meanH = d.states > 0 ? sumH / d.states : 0;
+        profile.depths.push_back(d);
+    }
+
+    // P_i(v) and the evaluation cost, on random walks from the start as deep
+    // as the last threshold RunHeuristicProfile predicts.
+    const int walkDepth = std::max(profile.startH, 1) + std::max(options.thresholds, 1) - 1;
+    const MoveTable<kDynamicGroupSize> moves(p);
+    std::mt19937 rng(options.seed);
+    std::vector<std::vector<double>> weightAtH(walkDepth + 1); // [depth][h]: summed walk weights
+    std::vector<double> weightAt(walkDepth + 1, 0.0);
+    std::vector<State> walk;
+    std::vector<double> weights;
+    std::vector<int> hs;
+    std::vector<int> timed;
+    std::chrono::steady_clock::duration evaluating{0};
+    std::uint64_t evaluations = 0;
+    for (std::size_t sample = 0; sample < options.samples; ++sample) {
+        RandomWalk(moves, p.smallState, walkDepth, rng, walk, weights);
+        hs.resize(walk.size());
+        EvaluateAll(*heuristic, kind, p, walk.data(), walk.size(), hs.data());
+
+        // Time the part of the walk the last IDA* pass would evaluate: up to the
+        // first node above the threshold. Deeper nodes tend to cost more.
+        std::size_t visited = 0;
+        while (visited < walk.size() && static_cast<int>(visited) + hs[visited] <= walkDepth) ++visited;
+        visited = std::min(visited + 1, walk.size());
+        timed.resize(visited);
+        const auto started = std::chrono::steady_clock::now();
+        EvaluateAll(*heuristic, kind, p, walk.data(), visited, timed.data());
+        evaluating += std::chrono::steady_clock::now() - started;
+        evaluations += visited;
+
+        for (std::size_t i = 0; i < walk.size(); ++i) {
+            std::vector<double>& row = weightAtH[i];
+            if (static_cast<std::size_t>(hs[i]) >= row.size()) row.resize(hs[i] + 1, 0.0);
+            row[hs[i]] += weights[i];
+            weightAt[i] += weights[i];
+        }
+    }
+    profile.nanosPerEvaluation = evaluations == 0 ? 0
+        : static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(evaluating).count()) / evaluations;
+
+    for (std::size_t i = 0; i < weightAtH.size() && weightAt[i] > 0; ++i) {
+        std::vector<double> atMost;
+        double sum = 0;
+        for (double w : weightAtH[i]) {
+            sum += w;
+            atMost.push_back(sum / weightAt[i]);
+        }
+        profile.hAtMost.push_back(std::move(atMost));
+    }
+    return profile;
+}
+
+double PredictIdaNodes(const std::vector<double>& treeSizes,
+                       const std::vector<std::vector<double>>& hAtMost,
+                       int threshold) {
+    double nodes = 0;
+    for (int i = 0; i <= threshold && static_cast<std::size_t>(i) < treeSizes.size(); ++i) {
+        const int v = threshold - i;
+        double p = 1.0;
+        if (!hAtMost.empty()) {
+            // Deeper than the walks went: the deepest measured distribution.
+            const std::vector<double>& atMost = hAtMost[std::min<std::size_t>(i, hAtMost.size() - 1)];
+            p = atMost[std::min<std::size_t>(v, atMost.size() - 1)];
+        }
+        nodes += treeSizes[i] * p;
+    }
+    return std::max(nodes, 1.0);
+}
+
+void RunHeuristicProfile(const Problem& p, const ProfileOptions& options, std::ostream& out) {
+    const auto distances = ComputeExactDistances(p, options.maxDepth, options.maxStates);
+    int deepest = 0;
+    for (const auto& entry : distances) deepest = std::max(deepest, entry.second);
+
+    std::vector<std::vector<State>> statesByDepth(deepest + 1);
+    for (const auto& entry : distances) statesByDepth[entry.second].push_back(entry.first);
+
+    out << "[profile] ring=" << p.large.size()
+        << " n=" << p.n
+        << " bfs_depth=" << deepest
+        << " bfs_states=" << distances.size()
+        << " walks=" << options.samples
+        << "\n";
+
+    for (HeuristicKind kind : kAllHeuristics) {
+        const HeuristicProfile profile = ProfileHeuristic(p, kind, statesByDepth, options);
+        const char* name = ToString(kind);
+
+        double sumH = 0, sumDepth = 0;
+        std::uint64_t exact = 0, states = 0, overestimates = 0;
+        for (const HeuristicProfile::Depth& d : profile.depths) {
+            out << "[profile] heuristic=" << name
+                << " depth=" << d.depth
+                << " states=" << d.states
+                << " mean_h=" << d.meanH
+                << " min_h=" << d.minH
+                << " max_h=" << d.maxH
+                << " exact=" << d.exact
+                << " over=" << d.overestimates
+                << " hist=";
+            bool first = true;
+            for (std::size_t h = 0; h < d.histogram.size(); ++h) {
+                if (d.histogram[h] == 0) continue;
+                out << (first ? "" : ",") << h << ":" << d.histogram[h];
+                first = false;
+            }
+            out << "\n";
+
+            if (d.depth > 0) {
+                sumH += d.meanH * d.states;
+                sumDepth += static_cast<double>(d.depth) * d.states;
+                exact += d.exact;
+                states += d.states;
+            }
+            overestimates += d.overestimates;
+        }
+
+        // IDA* passes from h(start) upward, and their running total.
+        const int firstThreshold = std::max(profile.startH, 1);
+        const int lastThreshold = firstThreshold + options.thresholds - 1;
+        const std::vector<double> treeSizes = BruteForceTreeSizes(p, p.smallState, lastThreshold);
+        const double branching = treeSizes.size() > 1 && treeSizes[treeSizes.size() - 2] > 0
+            ? treeSizes.back() / treeSizes[treeSizes.size() - 2] : 0;
+
+        out << "[profile] heuristic=" << name
+            << " h_over_distance=" << (sumDepth > 0 ? sumH / sumDepth : 0)
+            << " exact_fraction=" << (states > 0 ? static_cast<double>(exact) / states : 0)
+            << " overestimates=" << overestimates
+            << " ns_per_eval=" << profile.nanosPerEvaluation
+            << " h_start=" << profile.startH
+            << " branching=" << branching
+            << "\n";
+
+        double cumulative = 0;
+        for (int threshold = firstThreshold; threshold <= lastThreshold; ++threshold) {
+            const double pass = PredictIdaNodes(treeSizes, profile.hAtMost, threshold);
+            cumulative += pass;
+            // Each expansion evaluates h for about `branching` children.
+            const double millis = cumulative * branching * profile.nanosPerEvaluation / 1e6;
+            out << "[profile] heuristic=" << name
+                << " threshold=" << threshold
+                << " predicted_expanded=" << pass
+                << " cumulative=" << cumulative
+                << " predicted_ms=" << millis
+                << "\n";
+        }
+    }
+}
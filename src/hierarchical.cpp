@@ -0,0 +1,539 @@
+#include "hierarchical.h"
+
+#include "solvability.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr std::uint32_t kUnreachable = std::numeric_limits<std::uint32_t>::max();
+
+// Run starts tried; the shortest solution wins.
+constexpr std::size_t kRunStartsTried = 3;
+
+// A step's A* weighs h this much more than g: far fewer nodes, slightly longer steps.
+constexpr std::uint32_t kStepWeight = 4;
+
+// Depth of the detour search from each state on the path, and passes over the path.
+constexpr std::size_t kDetourDepth = 4;
+constexpr int kMaxShortenPasses = 4;
+// Size of the filter in front of the path's state table, in bits per state.
+constexpr std::size_t kFilterBitsPerState = 16;
+
+struct OpenStep {
+    std::uint32_t f;
+    std::uint32_t g;
+    std::uint64_t key;
+
+    // Lowest f first, deepest first among equals.
+    bool operator<(const OpenStep &other) const {
+        if (f != other.f) return f > other.f;
+        return g < other.g;
+    }
+};
+
+struct StepNode {
+    std::uint64_t parent; // the start nodes are their own parents
+    std::uint32_t g;
+};
+
+std::uint64_t SplitMix64(std::uint64_t &seed) {
+    std::uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Effective length of the jump from a position holding `large`: the shorter way round.
+std::uint32_t EffectiveJump(Disk large, std::uint32_t ring) {
+    const std::uint32_t jump = large % ring;
+    return std::min(jump, ring - jump);
+}
+
+// Colour of the disc at index `goalIndex` of the goal order 1..1 2..2 ... n..n.
+Disk GoalColour(std::uint32_t goalIndex, std::uint32_t n) {
+    return static_cast<Disk>(goalIndex % (n * n) / n + 1);
+}
+
+// Length of the goal order read around the ring from the disc at `from`,
+// skipping the blank. `phase` gets the goal index that disc takes: the discs
+// of its colour at the front of the stretch end their block.
+std::uint32_t GoalStretchAt(const State &s, std::uint32_t n, std::uint32_t from, std::uint32_t &phase) {
+    const std::uint32_t ring = static_cast<std::uint32_t>(s.small.size());
+    const Disk first = s.small[from];
+    std::uint32_t leading = 0;
+    for (std::uint32_t i = 0; i < ring && leading < n; ++i) {
+        const Disk disc = s.small[(from + i) % ring];
+        if (disc == 0) continue;
+        if (disc != first) break;
+        ++leading;
+    }
+    phase = static_cast<std::uint32_t>(first) * n - leading;
+
+    std::uint32_t matched = 0;
+    for (std::uint32_t i = 0; i < ring && matched + 1 < ring; ++i) {
+        const Disk disc = s.small[(from + i) % ring];
+        if (disc == 0) continue;
+        if (disc != GoalColour(phase + matched, n)) break;
+        ++matched;
+    }
+    return matched;
+}
+
+// Where a run of `length` discs starting at `start` ends, as an offset from
+// `start`, given the blank's offset: one further if the blank sits inside it.
+std::uint32_t RunEndOffset(std::uint32_t length, std::uint32_t blankOffset) {
+    return blankOffset >= 1 && blankOffset + 1 <= length ? length : length - 1;
+}
+
+struct Shortcut {
+    std::size_t end = 0;   // path index reached
+    std::size_t saved = 0; // moves saved over the path
+    std::vector<std::uint32_t> route;
+};
+
+} // namespace
+
+template <typename HeuristicT, int N>
+HierarchicalSolver<HeuristicT, N>::HierarchicalSolver(const Problem &p, HeuristicT &h, const SearchLimits &l,
+                                                      TraceRecorder *r)
+    : problem(p), heuristic(h), moves(p), limits(l), trace(r) {
+    heuristic.initialize(problem);
+
+    const std::uint32_t ring = static_cast<std::uint32_t>(problem.large.size());
+    const std::size_t keys = static_cast<std::size_t>(ring) * (static_cast<std::size_t>(problem.n) + 1);
+    std::uint64_t seed = 0x6a09e667f3bcc908ULL;
+    zobrist.resize(keys);
+    for (std::uint64_t &key : zobrist) key = SplitMix64(seed);
+
+    // One BFS of the blank's moves per starting position.
+    blankHops.assign(static_cast<std::size_t>(ring) * ring, std::numeric_limits<std::uint16_t>::max());
+    std::vector<std::uint32_t> queue;
+    for (std::uint32_t from = 0; from < ring; ++from) {
+        std::uint16_t *row = &blankHops[static_cast<std::size_t>(from) * ring];
+        queue.assign(1, from);
+        row[from] = 0;
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const std::uint32_t at = queue[head];
+            const BlankMoves &m = moves[at];
+            for (std::uint32_t i = 0; i < m.count; ++i) {
+                if (row[m.to[i]] != std::numeric_limits<std::uint16_t>::max()) continue;
+                row[m.to[i]] = static_cast<std::uint16_t>(row[at] + 1);
+                queue.push_back(m.to[i]);
+            }
+        }
+    }
+
+    // The jumps (not +-1 moves) that land the blank on each position, bucketed by landing position.
+    landingStart.assign(ring + 1, 0);
+    for (std::uint32_t b = 0; b < ring; ++b) {
+        const std::uint32_t jump = EffectiveJump(problem.large[b], ring);
+        if (jump < 2) continue;
+        longestSkip = std::max(longestSkip, jump - 1);
+        ++landingStart[moves[b].to[0] + 1];
+        ++landingStart[moves[b].to[1] + 1];
+    }
+    for (std::uint32_t pos = 0; pos < ring; ++pos) landingStart[pos + 1] += landingStart[pos];
+    landingFrom.resize(landingStart[ring]);
+    std::vector<std::uint32_t> fill(landingStart.begin(), landingStart.end() - 1);
+    for (std::uint32_t b = 0; b < ring; ++b) {
+        if (EffectiveJump(problem.large[b], ring) < 2) continue;
+        landingFrom[fill[moves[b].to[0]]++] = b;
+        landingFrom[fill[moves[b].to[1]]++] = b;
+    }
+}
+
+template <typename HeuristicT, int N>
+std::uint64_t HierarchicalSolver<HeuristicT, N>::hashOf(const State &s) const {
+    const std::size_t keys = static_cast<std::size_t>(problem.n) + 1;
+    std::uint64_t hash = 0;
+    for (std::size_t i = 0; i < s.small.size(); ++i) hash ^= zobrist[i * keys + s.small[i]];
+    return hash;
+}
+
+template <typename HeuristicT, int N>
+bool HierarchicalSolver<HeuristicT, N>::extendRun(std::uint32_t &runStart, std::uint32_t phase, std::uint32_t runLength,
+                                                  State &state, std::vector<std::uint32_t> &blanks) {
+    const std::uint32_t ring = static_cast<std::uint32_t>(problem.large.size());
+    const std::uint32_t n = static_cast<std::uint32_t>(problem.n);
+    const Disk colour = GoalColour(phase + runLength, n);
+    // Offset of the run's unfinished block: the discs from there on are all `colour`.
+    const std::uint32_t blockStart = runLength - std::min(runLength, (phase + runLength) % n);
+    auto block = [&](std::uint32_t runIndex) { return (phase + runIndex) % (n * n) / n; };
+
+    // A node is (run start, disc being brought, blank), packed into one key.
+    auto keyOf = [&](std::uint64_t start, std::uint64_t disc, std::uint64_t blank) {
+        return (start * ring + disc) * ring + blank;
+    };
+    auto offset = [&](std::uint32_t pos, std::uint32_t start) { return (pos + ring - start) % ring; };
+
+    // Moves the disc needs to reach the slot behind the run (or a free slot of
+    // its block) without passing through the run, per run start: one BFS
+    // backwards from those slots over the positions outside the run.
+    std::unordered_map<std::uint32_t, std::vector<std::uint16_t>> discHops;
+    auto hopsFor = [&](std::uint32_t start) -> const std::vector<std::uint16_t> & {
+        auto found = discHops.find(start);
+        if (found != discHops.end()) return found->second;
+        std::vector<std::uint16_t> &hops = discHops[start];
+        hops.assign(ring, std::numeric_limits<std::uint16_t>::max());
+        std::vector<std::uint32_t> queue;
+        for (std::uint32_t o = blockStart; o <= runLength; ++o) {
+            hops[(start + o) % ring] = 0;
+            queue.push_back((start + o) % ring);
+        }
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            // The disc at p moves to q when the blank at q moves to p.
+            const std::uint32_t q = queue[head];
+            const BlankMoves &m = moves[q];
+            for (std::uint32_t i = 0; i < m.count; ++i) {
+                const std::uint32_t p = m.to[i];
+                if (offset(p, start) <= runLength || hops[p] != std::numeric_limits<std::uint16_t>::max()) continue;
+                hops[p] = static_cast<std::uint16_t>(hops[q] + 1);
+                queue.push_back(p);
+            }
+        }
+        return hops;
+    };
+
+    // Discs between the run's end and the disc brought (0 at the goal), and a
+    // guess at the moves left: two per move of the disc, as the blank has to
+    // get round it between them, plus the blank's way to the first.
+    auto estimate = [&](std::uint32_t start, std::uint32_t disc, std::uint32_t blank, std::uint32_t &gap) {
+        const std::uint32_t blankOffset = offset(blank, start);
+        const std::uint32_t end = RunEndOffset(runLength, blankOffset);
+        const std::uint32_t discOffset = offset(disc, start);
+        // A disc dropped into the run's last block has joined it too.
+        gap = discOffset <= end + 1 ? 0 : discOffset - end - 1 - (blankOffset > end && blankOffset < discOffset ? 1 : 0);
+        if (gap == 0) return 0u;
+
+        const std::vector<std::uint16_t> &toRun = hopsFor(start);
+        const std::uint32_t hops = toRun[disc];
+        if (hops == std::numeric_limits<std::uint16_t>::max()) return 4 * ring; // only by moving the run
+        const std::uint16_t *fromBlank = &blankHops[static_cast<std::size_t>(blank) * ring];
+        std::uint32_t travel = std::numeric_limits<std::uint32_t>::max();
+        auto consider = [&](std::uint32_t next) {
+            if (toRun[next] < hops) travel = std::min<std::uint32_t>(travel, fromBlank[next]);
+        };
+        consider((disc + 1) % ring);
+        consider((disc + ring - 1) % ring);
+        for (std::uint32_t i = landingStart[disc]; i < landingStart[disc + 1]; ++i) consider(landingFrom[i]);
+        return travel + 2 * hops - 1;
+    };
+
+    std::unordered_map<std::uint64_t, StepNode> nodes;
+    std::priority_queue<OpenStep> open;
+    const std::uint32_t startBlankOffset = offset(state.zeroIndex, runStart);
+    const std::uint32_t startEnd = RunEndOffset(runLength, startBlankOffset);
+    for (std::uint32_t p = 0; p < ring; ++p) {
+        if (state.small[p] != colour || offset(p, runStart) <= startEnd) continue;
+        std::uint32_t gap = 0;
+        const std::uint32_t h = estimate(runStart, p, state.zeroIndex, gap);
+        const std::uint64_t key = keyOf(runStart, p, state.zeroIndex);
+        nodes.emplace(key, StepNode{key, 0});
+        open.push(OpenStep{kStepWeight * h, 0, key});
+    }
+
+    while (!open.empty()) {
+        const OpenStep top = open.top();
+        open.pop();
+        if (top.g > nodes[top.key].g) continue; // reached more cheaply since
+        const std::uint32_t blank = static_cast<std::uint32_t>(top.key % ring);
+        const std::uint32_t disc = static_cast<std::uint32_t>(top.key / ring % ring);
+        const std::uint32_t start = static_cast<std::uint32_t>(top.key / ring / ring);
+
+        std::uint32_t gap = 0;
+        estimate(start, disc, blank, gap);
+        if (gap == 0) {
+            std::vector<std::uint32_t> route;
+            for (std::uint64_t key = top.key; nodes[key].parent != key; key = nodes[key].parent) {
+                route.push_back(static_cast<std::uint32_t>(key % ring));
+            }
+            for (auto it = route.rbegin(); it != route.rend(); ++it) {
+                ApplyBlankMove(state, *it);
+                blanks.push_back(*it);
+            }
+            runStart = start;
+            return true;
+        }
+
+        stop = limits.Check(++searchStats.expanded);
+        if (stop != StopReason::None) {
+            return false;
+        }
+
+        const std::uint32_t blankOffset = offset(blank, start);
+        const std::uint32_t end = RunEndOffset(runLength, blankOffset);
+        const bool insideRun = end == runLength;
+        const BlankMoves &m = moves[blank];
+        for (std::uint32_t i = 0; i < m.count; ++i) {
+            const std::uint32_t to = m.to[i];
+            const std::uint32_t toOffset = offset(to, start);
+            std::uint32_t nextStart = start;
+            if (toOffset <= end) {
+                // A run disc. Stepping aside keeps the order; a jump keeps the
+                // colours in order only if every disc it passes has the jumping
+                // disc's colour, and it has to land in or right next to the run.
+                if (to == (blank + 1) % ring || to == (blank + ring - 1) % ring) {
+                    if (toOffset == 0) nextStart = blank;
+                } else {
+                    const std::uint32_t moved = insideRun && toOffset > blankOffset ? toOffset - 1 : toOffset;
+                    std::uint32_t first = moved, last = moved; // run indices it passes, itself included
+                    if (insideRun) {
+                        (toOffset > blankOffset ? first : last) = toOffset > blankOffset ? blankOffset : blankOffset - 1;
+                    } else if (blankOffset == ring - 1) {
+                        first = 0;
+                        nextStart = blank;
+                    } else if (blankOffset == end + 1) {
+                        last = runLength - 1;
+                    } else {
+                        continue;
+                    }
+                    if (block(first) != block(last)) continue;
+                    if (toOffset == 0) nextStart = (start + 1) % ring;
+                }
+            } else if (insideRun && !(to == disc && blankOffset >= blockStart)) {
+                continue; // the disc would land inside the run, other than one of its colour in its block
+            }
+            ++searchStats.generated;
+
+            const std::uint32_t nextDisc = to == disc ? blank : disc;
+            const std::uint64_t key = keyOf(nextStart, nextDisc, to);
+            const std::uint32_t g = top.g + 1;
+            const auto found = nodes.find(key);
+            if (found != nodes.end() && found->second.g <= g) continue;
+            nodes[key] = StepNode{top.key, g};
+            std::uint32_t nextGap = 0;
+            open.push(OpenStep{g + kStepWeight * estimate(nextStart, nextDisc, to, nextGap), g, key});
+        }
+    }
+    return false;
+}
+
+template <typename HeuristicT, int N>
+bool HierarchicalSolver<HeuristicT, N>::buildRun(std::uint32_t runStart, std::uint32_t phase, std::uint32_t runLength,
+                                                 State &state, std::vector<std::uint32_t> &blanks) {
+    const std::uint32_t ring = static_cast<std::uint32_t>(problem.large.size());
+    for (; runLength + 1 < ring; ++runLength) {
+        if (!extendRun(runStart, phase, runLength, state, blanks)) {
+            return false;
+        }
+        if (trace.enabled()) {
+            trace.Record(state, static_cast<int>(blanks.size() - 1), heuristic.template Evaluate<N>(state),
+                         kTraceNoMove, TraceEvent::Expanded);
+        }
+    }
+
+    // The run holds every disc. If the blank is inside it, walk it out the nearer way.
+    const std::uint32_t blankOffset = (state.zeroIndex + ring - runStart) % ring;
+    const bool backwards = blankOffset <= runLength - blankOffset;
+    for (std::uint32_t step = 0; step < ring && !state.IsGoal<N>(problem.n); ++step) {
+        const std::uint32_t to = backwards ? (state.zeroIndex + ring - 1) % ring : (state.zeroIndex + 1) % ring;
+        ApplyBlankMove(state, to);
+        blanks.push_back(to);
+    }
+    return state.IsGoal<N>(problem.n);
+}
+
+template <typename HeuristicT, int N>
+std::size_t HierarchicalSolver<HeuristicT, N>::shorten(const State &start, std::vector<std::uint32_t> &blanks) {
+    const std::size_t keys = static_cast<std::size_t>(problem.n) + 1;
+    auto hashAfter = [&](std::uint64_t hash, const State &s, std::uint32_t to) {
+        const std::size_t from = s.zeroIndex;
+        const Disk disc = s.small[to];
+        return hash ^ zobrist[from * keys] ^ zobrist[from * keys + disc] ^ zobrist[to * keys + disc] ^
+               zobrist[to * keys];
+    };
+
+    std::size_t saved = 0;
+    for (int pass = 0; pass < kMaxShortenPasses; ++pass) {
+        // The last index of every state on the path, behind a bit filter that
+        // turns away most states off the path without a table lookup.
+        std::unordered_map<std::uint64_t, std::size_t> last;
+        last.reserve(blanks.size());
+        std::size_t filterBits = 64;
+        while (filterBits < kFilterBitsPerState * blanks.size()) filterBits *= 2;
+        std::vector<std::uint64_t> filter(filterBits / 64);
+        auto mayBeOnPath = [&](std::uint64_t h) {
+            const std::uint64_t bit = h & (filterBits - 1);
+            return (filter[bit / 64] >> (bit % 64) & 1) != 0;
+        };
+        State s = start;
+        std::uint64_t hash = hashOf(s);
+        for (std::size_t i = 0; i < blanks.size(); ++i) {
+            if (i > 0) {
+                hash = hashAfter(hash, s, blanks[i]);
+                ApplyBlankMove(s, blanks[i]);
+            }
+            last[hash] = i;
+            const std::uint64_t bit = hash & (filterBits - 1);
+            filter[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+
+        std::vector<std::uint32_t> out{blanks[0]};
+        out.reserve(blanks.size());
+        State current = start;
+        hash = hashOf(current);
+        std::vector<std::uint32_t> route;
+        Shortcut best;
+
+        // Depth-first up to kDetourDepth moves from path state `from`, keeping
+        // the route to the later path state that saves the most moves.
+        auto search = [&](auto &self, std::size_t from, std::uint64_t h, std::uint32_t previous) -> void {
+            ++searchStats.generated;
+            const auto found = mayBeOnPath(h) ? last.find(h) : last.end();
+            if (found != last.end() && found->second > from + route.size() &&
+                found->second - from - route.size() > best.saved) {
+                best.end = found->second;
+                best.saved = found->second - from - route.size();
+                best.route = route;
+            }
+            if (route.size() == kDetourDepth) return;
+
+            const std::uint32_t blank = current.zeroIndex;
+            const BlankMoves &m = moves[blank];
+            for (std::uint32_t i = 0; i < m.count; ++i) {
+                const std::uint32_t to = m.to[i];
+                if (to == previous) continue; // straight back
+                const std::uint64_t next = hashAfter(h, current, to);
+                ApplyBlankMove(current, to);
+                route.push_back(to);
+                self(self, from, next, blank);
+                route.pop_back();
+                ApplyBlankMove(current, blank);
+            }
+        };
+
+        std::size_t i = 0;
+        while (i + 1 < blanks.size()) {
+            best = Shortcut();
+            search(search, i, hash, kUnreachable);
+            if (best.saved == 0) {
+                best.end = i + 1;
+                best.route.assign(1, blanks[i + 1]);
+            }
+            for (std::uint32_t to : best.route) {
+                hash = hashAfter(hash, current, to);
+                ApplyBlankMove(current, to);
+                out.push_back(to);
+            }
+            saved += best.saved;
+            i = best.end;
+        }
+
+        if (out.size() == blanks.size() || !(current == s)) break; // nothing saved, or a hash collision
+        blanks.swap(out);
+    }
+    return saved;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> HierarchicalSolver<HeuristicT, N>::solve(bool debug) {
+    searchStats = SearchStats();
+    stop = StopReason::None;
+
+    const Solvability solvability = AnalyzeSolvability(problem);
+    if (debug) {
+        std::cout << "[Hier] pre-check: " << ToString(solvability) << std::endl;
+    }
+    if (solvability != Solvability::Solvable) {
+        // Unknown means the ring is not n*n + 1 long, and there is no goal layout to fill.
+        return {};
+    }
+
+    const State &start = problem.smallState;
+    const std::uint32_t ring = static_cast<std::uint32_t>(problem.large.size());
+    if (start.IsGoal<N>(problem.n)) {
+        return {start};
+    }
+
+    // Run starts: the discs with the longest stretch of the goal order after them.
+    const std::uint32_t n = static_cast<std::uint32_t>(problem.n);
+    std::uint32_t phase = 0;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> starts; // (-length, position)
+    for (std::uint32_t pos = 0; pos < ring; ++pos) {
+        if (start.small[pos] != 0) starts.emplace_back(ring - GoalStretchAt(start, n, pos, phase), pos);
+    }
+    // The tail of a stretch is a stretch too; try only one start per stretch.
+    std::sort(starts.begin(), starts.end());
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> picked; // (position, length)
+    for (std::size_t i = 0; i < starts.size() && picked.size() < kRunStartsTried; ++i) {
+        const std::uint32_t pos = starts[i].second;
+        const bool inside = std::any_of(picked.begin(), picked.end(), [&](const auto &run) {
+            return (pos + ring - run.first) % ring <= run.second;
+        });
+        if (!inside) picked.emplace_back(pos, ring - starts[i].first);
+    }
+
+    std::vector<std::uint32_t> best;
+    for (const auto &run : picked) {
+        ++searchStats.iterations;
+        const std::uint32_t runStart = run.first;
+        const std::uint32_t runLength = GoalStretchAt(start, n, runStart, phase);
+        State s = start;
+        std::vector<std::uint32_t> blanks{s.zeroIndex};
+        const bool built = buildRun(runStart, phase, runLength, s, blanks);
+        if (stop != StopReason::None) {
+            if (debug) {
+                std::cout << "[Hier] stopped (limits exceeded) expanded=" << searchStats.expanded << std::endl;
+            }
+            return {};
+        }
+        if (!built) {
+            if (debug) {
+                std::cout << "[Hier] run start=" << runStart << " gave up" << std::endl;
+            }
+            continue;
+        }
+
+        if (debug) {
+            std::cout << "[Hier] run start=" << runStart
+                      << " matched=" << runLength
+                      << " built_moves=" << blanks.size() - 1
+                      << " expanded=" << searchStats.expanded
+                      << std::endl;
+        }
+        if (best.empty() || blanks.size() < best.size()) best.swap(blanks);
+        // Already in goal order: nothing but a walk of the blank, which no other start beats.
+        if (runLength + 1 == ring) break;
+    }
+
+    if (best.empty()) {
+        if (debug) {
+            std::cout << "[Hier] no solution found expanded=" << searchStats.expanded << std::endl;
+        }
+        return {};
+    }
+    // Only the shortest is shortened: on big rings the pass costs more than building.
+    const std::size_t saved = shorten(start, best);
+
+    std::vector<State> solution{start};
+    solution.reserve(best.size());
+    for (std::size_t i = 1; i < best.size(); ++i) {
+        State next = solution.back();
+        ApplyBlankMove(next, best[i]);
+        solution.push_back(std::move(next));
+    }
+    trace.Record(solution.back(), static_cast<int>(best.size() - 1), 0, solution[solution.size() - 2].zeroIndex,
+                 TraceEvent::Goal);
+    if (debug) {
+        std::cout << "[Hier] solved cost=" << best.size() - 1
+                  << " shortened_by=" << saved
+                  << " lower_bound=" << heuristic.template Evaluate<N>(start)
+                  << std::endl;
+    }
+    return solution;
+}
+
+template <typename HeuristicT, int N>
+std::vector<State> HierarchicalSolver<HeuristicT, N>::solve() {
+    return solve(false);
+}
+
+#define INSTANTIATE_HIERARCHICAL(H) AB_INSTANTIATE_FOR_GROUP_SIZES(HierarchicalSolver, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_HIERARCHICAL)
@@ -0,0 +1,110 @@
+#include "hop_table.h"
+#include "move_table.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace {
+
+// Blank distances from the nearest of `sources` to every ring position,
+// written to `out[pos * stride]`.
+void BlankDistancesFrom(const MoveTable<kDynamicGroupSize>& moves,
+                        const std::vector<std::uint32_t>& sources,
+                        std::uint32_t ring,
+                        HopTable::Hops* out,
+                        std::size_t stride,
+                        std::vector<std::uint32_t>& queue,
+                        std::vector<int>& distance) {
+    distance.assign(ring, -1);
+    queue.clear();
+    for (std::uint32_t s : sources) {
+        distance[s] = 0;
+        queue.push_back(s);
+    }
+
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const std::uint32_t at = queue[head];
+        const BlankMoves& m = moves[at];
+        for (std::uint32_t i = 0; i < m.count; ++i) {
+            const std::uint32_t next = m.to[i];
+            if (distance[next] < 0) {
+                distance[next] = distance[at] + 1;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    for (std::uint32_t pos = 0; pos < ring; ++pos) {
+        assert(distance[pos] >= 0 && distance[pos] <= std::numeric_limits<HopTable::Hops>::max());
+        out[pos * stride] = static_cast<HopTable::Hops>(distance[pos]);
+    }
+}
+
+} // namespace
+
+// A BFS of the blank's moves starting from a slot gives, for every position,
+// how far the blank must travel from the slot to it, which is how far a disc
+// there must travel to reach the slot. Starting from a whole block at once
+// gives the distance to the block's nearest slot.
+void HopTable::Build(const Problem& p) {
+    ring = static_cast<std::uint32_t>(p.large.size());
+    group = p.n;
+    assert(group > 0 && group < ring);
+
+    blockSize = group <= static_cast<std::uint32_t>(kMaxExactHopGroupSize) ? 1 : group;
+    columns = (ring + blockSize - 1) / blockSize;
+
+    const MoveTable<kDynamicGroupSize> moves(p);
+    std::vector<std::uint32_t> queue, sources;
+    std::vector<int> distance;
+
+    slotHops.assign(static_cast<std::size_t>(ring) * columns, 0);
+    for (std::uint32_t column = 0; column < columns; ++column) {
+        sources.clear();
+        for (std::uint32_t slot = column * blockSize; slot < std::min(ring, (column + 1) * blockSize); ++slot) {
+            sources.push_back(slot);
+        }
+        BlankDistancesFrom(moves, sources, ring, &slotHops[column], columns, queue, distance);
+    }
+
+    segmentHops.clear();
+    if (!IsExact()) return;
+
+    segmentHops.assign(static_cast<std::size_t>(ring) * ring * 2, 0);
+    for (std::uint32_t from = 0; from < ring; ++from) {
+        const Hops* row = &slotHops[static_cast<std::size_t>(from) * ring];
+        Hops* out = &segmentHops[static_cast<std::size_t>(from) * ring * 2];
+        for (std::uint32_t start = 0; start < ring; ++start) {
+            Hops best = std::numeric_limits<Hops>::max();
+            std::uint32_t slot = start;
+            for (std::uint32_t i = 0; i < group; ++i) {
+                best = std::min(best, row[slot]);
+                if (++slot == ring) slot = 0;
+            }
+            out[start] = out[start + ring] = best;
+        }
+    }
+}
+
+const HopTable::Hops* HopTable::SegmentRow(std::uint32_t from, Hops* scratch) const {
+    if (IsExact()) return &segmentHops[static_cast<std::size_t>(from) * ring * 2];
+
+    // A segment of n slots touches at most three blocks; the nearest of them
+    // is a lower bound on the nearest slot in the segment.
+    const Hops* row = &slotHops[static_cast<std::size_t>(from) * columns];
+    for (std::uint32_t start = 0; start < ring; ++start) {
+        std::uint32_t last = start + group - 1;
+        if (last >= ring) last -= ring;
+
+        std::uint32_t block = start / blockSize;
+        const std::uint32_t lastBlock = last / blockSize;
+        Hops best = row[block];
+        while (block != lastBlock) {
+            if (++block == columns) block = 0;
+            best = std::min(best, row[block]);
+        }
+        scratch[start] = scratch[start + ring] = best;
+    }
+    return scratch;
+}
@@ -1,13 +1,17 @@
 #include "ida_star.h"
 
 #include "common.h"
-#include "move.h"
-#include "util.h"
+#include "move_table.h"
+#include "perf_counters.h"
+#include "solvability.h"
 
 #include <cassert>
 #include <cstdint>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
 
 /*
 NOTE: I generated these doc comments with Claude.
@@ -39,91 +43,77 @@ namespace {
 // Sentinel return value used to signal success (goal found).
 constexpr int kFound = -1;
 
-// Apply a move to a state to generate a successor state.
-// This mirrors the logic in `astar.cpp` (GenerateMoveNode / ExpandNode).
-State ApplyMove(const Problem &problem, const State &parentState, Move move) {
-    State s = parentState;
-
-    const uint32_t numDisks = static_cast<uint32_t>(s.small.size());
-    const uint32_t largeValue = static_cast<uint32_t>(problem.large[s.zeroIndex]);
-
-    switch (move) {
-        case SWAP_RIGHT:
-            s.zeroIndex = static_cast<uint32_t>(
-                WrapIndex(static_cast<int>(s.zeroIndex + largeValue), static_cast<int>(numDisks)));
-            break;
-        case SWAP_LEFT:
-            s.zeroIndex = static_cast<uint32_t>(
-                WrapIndex(static_cast<int>(s.zeroIndex) - static_cast<int>(largeValue), static_cast<int>(numDisks)));
-            break;
-        case SWAP_N_RIGHT:
-            s.zeroIndex =
-                static_cast<uint32_t>(WrapIndex(static_cast<int>(s.zeroIndex + 1), static_cast<int>(numDisks)));
-            break;
-        case SWAP_N_LEFT:
-            s.zeroIndex = static_cast<uint32_t>(WrapIndex(static_cast<int>(s.zeroIndex) - 1, static_cast<int>(numDisks)));
-            break;
-        default:
-            assert(false);
-    }
-
-    // Perform the swap to move the zero to the new index.
-    s.small[parentState.zeroIndex] = s.small[s.zeroIndex];
-    s.small[s.zeroIndex] = 0;
-
-    return s;
-}
-
-// Enumerate legal moves from `state`.
-// Matches `ExpandNode` in `astar.cpp`:
-// - Always allow SWAP_LEFT and SWAP_RIGHT.
-// - Additionally allow SWAP_N_LEFT and SWAP_N_RIGHT only if the large disk value != 1.
-uint32_t GetMoves(const Problem &problem, const State &state, Move outMoves[4]) {
-    const uint32_t largeValue = static_cast<uint32_t>(problem.large[state.zeroIndex]);
-
-    outMoves[0] = SWAP_RIGHT;
-    outMoves[1] = SWAP_LEFT;
+// Sentinel return value used to unwind the DFS once the limits are exceeded.
+constexpr int kStopped = -2;
 
-    if (largeValue != 1) {
-        outMoves[2] = SWAP_N_RIGHT;
-        outMoves[3] = SWAP_N_LEFT;
-        return 4;
-    }
-
-    return 2;
-}
+const char kCheckpointMagic[9] = "ABIDACK1";
 
 } // namespace
 
-IDAStar::IDAStar(const Problem &p, Heuristic &h) : problem(p), heuristic(h) {
+template <typename HeuristicT, int N>
+IDAStar<HeuristicT, N>::IDAStar(const Problem &p, HeuristicT &h, const SearchLimits &l, const CheckpointOptions &c,
+                                TraceRecorder *recorder)
+    : problem(p), heuristic(h), moves(p), limits(l), checkpoint(c), trace(recorder) {
     heuristic.initialize(problem);
 }
 
-std::vector<State> IDAStar::solve(bool debug) {
+template <typename HeuristicT, int N>
+std::vector<State> IDAStar<HeuristicT, N>::solve(bool debug) {
+    searchStats = SearchStats();
+    stop = StopReason::None;
+
+    // Without this, an unreachable goal would keep raising the threshold forever.
+    const Solvability solvability = AnalyzeSolvability(problem);
+    if (debug) {
+        std::cout << "[IDA*] pre-check: " << ToString(solvability) << std::endl;
+    }
+    if (solvability == Solvability::Unsolvable) {
+        return {};
+    }
+
     // `path` is the current DFS path from start to the current node.
     // If we reach the goal, this path is exactly the solution we return.
     std::vector<State> path;
     path.reserve(1024);
+    frames.assign(1024, Frame{0, 0});
 
     const State start = problem.smallState;
     path.push_back(start);
 
     // Initial threshold is f(start) = g(0) + h(start) = h(start).
-    int threshold = heuristic(start);
-
-    // Debug counters across all iterations.
-    uint64_t totalExpanded = 0;
-    uint64_t totalPruned = 0;
-    uint32_t iteration = 0;
+    progress = Progress();
+    progress.threshold = heuristic.template Evaluate<N>(start);
+    replayDepth = 0;
+
+    bool resumed = checkpoint.resume && readCheckpoint();
+    if (debug && resumed) {
+        std::cout << "[IDA*] resumed iter=" << progress.iteration
+                  << " threshold=" << progress.threshold
+                  << " depth=" << replayDepth - 1
+                  << " expanded=" << searchStats.expanded
+                  << std::endl;
+    }
+    nextCheckpoint = SearchLimits::Clock::now() + checkpoint.interval;
 
     // Iteratively increase the threshold until a solution is found.
     while (true) {
-        IterationStats stats;
+        // A resumed pass continues with the counters it had.
+        if (!resumed) {
+            progress.current = IterationStats();
+            ++searchStats.iterations;
+        }
+        resumed = false;
+        IterationStats &stats = progress.current;
+        const int threshold = progress.threshold;
+        const uint32_t iteration = progress.iteration;
+        trace.RecordBound(threshold);
 
         std::vector<State> solution;
         solution.reserve(path.size());
 
         // Run bounded DFS from the start.
+        const uint64_t expandedBefore = stats.expanded;
+        PerfScope pass(PerfPhase::IDAPass);
         int t = dfsBounded(/*current=*/start,
                            /*g=*/0,
                            /*threshold=*/threshold,
@@ -131,6 +121,7 @@ std::vector<State> IDAStar::solve(bool debug) {
                            /*outSolution=*/solution,
                            /*debug=*/debug,
                            /*stats=*/stats);
+        pass.Stop(stats.expanded - expandedBefore);
 
         if (debug) {
             std::cout << "[IDA*] iter=" << iteration
@@ -140,16 +131,26 @@ std::vector<State> IDAStar::solve(bool debug) {
                       << std::endl;
         }
 
-        totalExpanded += stats.expanded;
-        totalPruned += stats.pruned;
+        progress.totalExpanded += stats.expanded;
+        progress.totalPruned += stats.pruned;
+
+        if (t == kStopped) {
+            if (debug) {
+                std::cout << "[IDA*] stopped (limits exceeded)"
+                          << " iters=" << (iteration + 1)
+                          << " total_expanded=" << progress.totalExpanded
+                          << std::endl;
+            }
+            return {};
+        }
 
         if (t == kFound) {
             if (debug) {
                 std::cout << "[IDA*] solved"
                           << " iters=" << (iteration + 1)
                           << " final_threshold=" << threshold
-                          << " total_expanded=" << totalExpanded
-                          << " total_pruned=" << totalPruned
+                          << " total_expanded=" << progress.totalExpanded
+                          << " total_pruned=" << progress.totalPruned
                           << std::endl;
             }
             // Found: `solution` is start->goal inclusive.
@@ -161,8 +162,8 @@ std::vector<State> IDAStar::solve(bool debug) {
                 std::cout << "[IDA*] no solution"
                           << " iters=" << (iteration + 1)
                           << " last_threshold=" << threshold
-                          << " total_expanded=" << totalExpanded
-                          << " total_pruned=" << totalPruned
+                          << " total_expanded=" << progress.totalExpanded
+                          << " total_pruned=" << progress.totalPruned
                           << std::endl;
             }
             // No candidate for a higher threshold => no solution reachable.
@@ -170,16 +171,18 @@ std::vector<State> IDAStar::solve(bool debug) {
         }
 
         // Raise the threshold to the smallest f-cost that exceeded the old bound.
-        threshold = t;
-        ++iteration;
+        progress.threshold = t;
+        ++progress.iteration;
     }
 }
 
-std::vector<State> IDAStar::solve() {
+template <typename HeuristicT, int N>
+std::vector<State> IDAStar<HeuristicT, N>::solve() {
     return solve(false);
 }
 
-int IDAStar::dfsBounded(const State &current,
+template <typename HeuristicT, int N>
+int IDAStar<HeuristicT, N>::dfsBounded(const State &current,
                         int g,
                         int threshold,
                         std::vector<State> &path,
@@ -188,46 +191,87 @@ int IDAStar::dfsBounded(const State &current,
                         IterationStats &stats) {
     (void)debug; // debug printing is handled at the iteration level
 
-    // Compute f = g + h and prune if it exceeds the threshold.
-    const int h = heuristic(current);
-    const int f = g + h;
-    if (f > threshold) {
-        // Pruned by the current bound.
-        ++stats.pruned;
-
-        // Return the f-cost that caused the cutoff; caller uses min of these
-        // to determine the next threshold.
-        return f;
-    }
-
-    // Goal test.
-    if (current.IsGoal(problem.n)) {
-        // Success: copy the current path (which already includes `current`)
-        // into `outSolution`.
-        outSolution = path;
-        return kFound;
+    const std::size_t depth = path.size() - 1;
+    if (depth >= frames.size()) {
+        frames.resize(2 * frames.size());
     }
 
     int minExcess = std::numeric_limits<int>::max();
+    uint32_t first = 0;
+    // The first child's subtree is also being re-entered from a checkpoint.
+    bool replayChild = false;
+
+    if (depth < replayDepth) {
+        // Resuming: this node was evaluated, counted and explored up to child
+        // `first` before the checkpoint was written.
+        first = frames[depth].child;
+        minExcess = frames[depth].minExcess;
+        replayChild = depth + 1 < replayDepth;
+        if (!replayChild) {
+            replayDepth = 0;
+        }
+    } else {
+        // Compute f = g + h and prune if it exceeds the threshold.
+        const int h = heuristic.template Evaluate<N>(current);
+        const int f = g + h;
+        const uint32_t from = depth > 0 ? path[depth - 1].zeroIndex : kTraceNoMove;
+        if (f > threshold) {
+            // Pruned by the current bound.
+            ++stats.pruned;
+            trace.Record(current, g, h, from, TraceEvent::Pruned);
+
+            // Return the f-cost that caused the cutoff; caller uses min of these
+            // to determine the next threshold.
+            return f;
+        }
 
-    // We're about to generate successors from this node.
-    ++stats.expanded;
+        // Goal test.
+        if (current.IsGoal<N>(problem.n)) {
+            // Success: copy the current path (which already includes `current`)
+            // into `outSolution`.
+            trace.Record(current, g, h, from, TraceEvent::Goal);
+            outSolution = path;
+            return kFound;
+        }
 
-    // Enumerate legal moves and DFS into children.
-    Move moves[4];
-    const uint32_t moveCount = GetMoves(problem, current, moves);
+        // We're about to generate successors from this node.
+        ++stats.expanded;
+        trace.Record(current, g, h, from, TraceEvent::Expanded);
+        stop = limits.Check(++searchStats.expanded);
+        if (checkpoint.enabled() &&
+            (stop != StopReason::None ||
+             (searchStats.expanded % kLimitCheckInterval == 0 && SearchLimits::Clock::now() >= nextCheckpoint))) {
+            // Resuming re-enters this node at its first child.
+            frames[depth] = Frame{0, minExcess};
+            writeCheckpoint(depth);
+        }
+        if (stop != StopReason::None) {
+            return kStopped;
+        }
+    }
 
-    for (uint32_t i = 0; i < moveCount; ++i) {
-        const Move m = moves[i];
-        State child = ApplyMove(problem, current, m);
+    // Enumerate legal moves and DFS into children. The move table lists the
+    // blank's destinations in the same order A* expands them.
+    const BlankMoves &blankMoves = moves[current.zeroIndex];
+
+    for (uint32_t i = first; i < blankMoves.count; ++i) {
+        State child = current;
+        ApplyBlankMove(child, blankMoves.to[i]);
+        if (replayChild) {
+            replayChild = false; // generated before the checkpoint
+        } else {
+            ++searchStats.generated;
+        }
 
         // Avoid cycles by not revisiting a state already on the current path.
         if (isOnPath(child, path)) {
+            trace.Record(child, g + 1, -1, current.zeroIndex, TraceEvent::Duplicate);
             continue;
         }
 
         // Extend path with this child.
         path.push_back(child);
+        frames[depth] = Frame{i, minExcess};
 
         // Recurse. Each action costs 1, so g increases by 1.
         int t = dfsBounded(/*current=*/child,
@@ -238,8 +282,8 @@ int IDAStar::dfsBounded(const State &current,
                            /*debug=*/debug,
                            /*stats=*/stats);
 
-        if (t == kFound) {
-            return kFound;
+        if (t == kFound || t == kStopped) {
+            return t;
         }
 
         if (t < minExcess) {
@@ -253,7 +297,8 @@ int IDAStar::dfsBounded(const State &current,
     return minExcess;
 }
 
-bool IDAStar::isOnPath(const State &s, const std::vector<State> &path) const {
+template <typename HeuristicT, int N>
+bool IDAStar<HeuristicT, N>::isOnPath(const State &s, const std::vector<State> &path) const {
     for (const State &ancestor : path) {
         if (ancestor == s) {
             return true;
@@ -261,3 +306,60 @@ bool IDAStar::isOnPath(const State &s, const std::vector<State> &path) const {
     }
     return false;
 }
+
+template <typename HeuristicT, int N>
+void IDAStar<HeuristicT, N>::writeCheckpoint(std::size_t depth) {
+    nextCheckpoint = SearchLimits::Clock::now() + checkpoint.interval;
+
+    const std::string tmpPath = checkpoint.path + ".tmp";
+    CheckpointWriter out(tmpPath, /*append=*/false);
+    out.PutHeader(kCheckpointMagic, CheckpointFingerprint(problem, "ida", typeid(HeuristicT).name()));
+    out.Put(progress.threshold);
+    out.Put(progress.iteration);
+    out.Put(progress.totalExpanded);
+    out.Put(progress.totalPruned);
+    out.Put(progress.current.expanded);
+    out.Put(progress.current.pruned);
+    out.Put(searchStats.expanded);
+    out.Put(searchStats.generated);
+    out.Put(searchStats.iterations);
+    out.Put(static_cast<uint64_t>(depth + 1));
+    for (std::size_t d = 0; d <= depth; ++d) {
+        out.Put(frames[d].child);
+        out.Put(frames[d].minExcess);
+    }
+    if (!out.Finish() || !ReplaceCheckpointFile(tmpPath, checkpoint.path)) {
+        WarnCheckpointFailed(checkpoint.path);
+    }
+}
+
+template <typename HeuristicT, int N>
+bool IDAStar<HeuristicT, N>::readCheckpoint() {
+    CheckpointReader in(checkpoint.path);
+    if (!in.IsOpen()) {
+        return false;
+    }
+    in.ExpectHeader(kCheckpointMagic, CheckpointFingerprint(problem, "ida", typeid(HeuristicT).name()),
+                    checkpoint.path);
+
+    uint64_t depthCount = 0;
+    bool ok = in.Get(progress.threshold) && in.Get(progress.iteration) &&
+              in.Get(progress.totalExpanded) && in.Get(progress.totalPruned) &&
+              in.Get(progress.current.expanded) && in.Get(progress.current.pruned) &&
+              in.Get(searchStats.expanded) && in.Get(searchStats.generated) && in.Get(searchStats.iterations) &&
+              in.Get(depthCount) && depthCount > 0;
+    if (ok && frames.size() < depthCount) {
+        frames.resize(depthCount);
+    }
+    for (uint64_t d = 0; ok && d < depthCount; ++d) {
+        ok = in.Get(frames[d].child) && in.Get(frames[d].minExcess);
+    }
+    if (!ok) {
+        throw std::runtime_error("truncated checkpoint: " + checkpoint.path);
+    }
+    replayDepth = static_cast<std::size_t>(depthCount);
+    return true;
+}
+
+#define INSTANTIATE_IDA_STAR(H) AB_INSTANTIATE_FOR_GROUP_SIZES(IDAStar, H)
+AB_FOR_EACH_HEURISTIC(INSTANTIATE_IDA_STAR)
@@ -1,68 +1,72 @@
-#include "astar.h"
-#include "ida_star.h"
+#include "absolver.h"
 #include "common.h"
+#include "exact_distances.h"
+#include "heuristic_profile.h"
+#include "move_table.h"
+#include "perf_counters.h"
+#include "portfolio.h"
 #include "problem.h"
+#include "service.h"
+#include "solve.h"
+#include "trace.h"
 
 #include <cassert>
-#include <cmath>
+#include <chrono>
 #include <cstdint>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <string>
 #include <vector>
 
 namespace {
 
 // ---------------------------- I/O + Utilities ----------------------------
 
-Problem ReadUserInput(std::size_t num_large) {
+SolveRequest ReadUserInput(std::size_t num_large) {
+    SolveRequest request;
+
     // Read large disks
-    std::vector<Disk> large(num_large);
+    request.large.resize(num_large);
     for (std::size_t i = 0; i < num_large; ++i) {
         int value;
         std::cin >> value;
-        large[i] = static_cast<Disk>(value);
+        request.large[i] = static_cast<Disk>(value);
     }
 
     // Read small disks
-    std::vector<Disk> small(num_large);
+    request.small.resize(num_large);
     for (std::size_t i = 0; i < num_large; ++i) {
         int value;
         std::cin >> value;
-        small[i] = static_cast<Disk>(value);
+        request.small[i] = static_cast<Disk>(value);
     }
 
-    const uint16_t groupSize = static_cast<uint16_t>(
-        std::floor(std::sqrt(static_cast<double>(num_large))));
-
-    return Problem(large, small, groupSize);
+    return request;
 }
 
+// Same text as `std::cout << s << std::endl` per state. Paths of large rings
+// (hierarchical solver, n = 32) run to ~80k states of 1025 discs, where
+// formatting disc by disc and flushing every line took longer than the solve.
 void PrintSolution(const std::vector<State>& solution) {
-    std::cout << "Solution is" << std::endl;
+    std::cout << "Solution is\n";
+    std::string line;
     for (const State& s : solution) {
-        std::cout << s << std::endl;
-    }
-}
-
-enum class SolverKind {
-    IDAStar,
-    AStar,
-};
-
-struct SolveOptions {
-    SolverKind solver = SolverKind::IDAStar;
-    bool debug = false; // pass through to solver (debug printing)
-};
-
-// Keep solver selection logic in one place.
-template <typename HeuristicT>
-std::vector<State> SolveProblem(const Problem& p, HeuristicT& heuristic, const SolveOptions& opts) {
-    if (opts.solver == SolverKind::IDAStar) {
-        IDAStar solver(p, heuristic);
-        return solver.solve(opts.debug);
-    } else {
-        AStar solver(p, heuristic);
-        return solver.solve(opts.debug);
+        line.clear();
+        for (std::size_t i = 0; i < s.small.size(); ++i) {
+            if (i > 0) line += ' ';
+            // Disk is unsigned 8-bit: at most three digits.
+            const unsigned value = s.small[i];
+            if (value >= 100) line += static_cast<char>('0' + value / 100);
+            if (value >= 10) line += static_cast<char>('0' + value / 10 % 10);
+            line += static_cast<char>('0' + value % 10);
+        }
+        line += '\n';
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
     }
+    std::cout.flush();
 }
 
 // ---------------------------- Debug / Test mode ----------------------------
@@ -102,6 +106,130 @@ void RunSanityTests() {
     assert(!g3.IsGoal(3));
 }
 
+// Compare every heuristic with exact distances on small random layouts.
+// h must never exceed the true distance to the nearest goal rotation.
+void RunHeuristicAdmissibilityTests() {
+    ZeroHeuristic zero;
+    MisplacedDiscHeuristic misplaced;
+    HopHeuristic hop;
+    HopConflictHeuristic hopConflict;
+
+    Heuristic* heuristics[] = {&zero, &misplaced, &hop, &hopConflict};
+    const char* names[] = {"ZeroHeuristic", "MisplacedDiscHeuristic", "HopHeuristic", "HopConflictHeuristic"};
+
+    std::mt19937 rng(355);
+    for (int n = 2; n <= 3; ++n) {
+        std::uniform_int_distribution<int> largeValue(1, n);
+        for (int layout = 0; layout < 4; ++layout) {
+            std::vector<Disk> large(RingSize(n));
+            for (Disk& d : large) d = static_cast<Disk>(largeValue(rng));
+
+            const Problem p(large, MakeGoalState(0, n).small, static_cast<uint16_t>(n));
+            const auto distances = ComputeExactDistances(p);
+
+            for (std::size_t i = 0; i < sizeof(heuristics) / sizeof(heuristics[0]); ++i) {
+                Heuristic& h = *heuristics[i];
+                h.initialize(p);
+
+                uint64_t overestimates = 0;
+                uint64_t sumH = 0;
+                uint64_t sumExact = 0;
+                for (const auto& entry : distances) {
+                    const int value = h(entry.first);
+                    if (value > entry.second) ++overestimates;
+                    sumH += static_cast<uint64_t>(value);
+                    sumExact += static_cast<uint64_t>(entry.second);
+                }
+
+                std::cout << "[admissible] n=" << n
+                          << " layout=" << layout
+                          << " " << names[i]
+                          << " states=" << distances.size()
+                          << " overestimates=" << overestimates
+                          << " mean_h=" << static_cast<double>(sumH) / distances.size()
+                          << " mean_exact=" << static_cast<double>(sumExact) / distances.size()
+                          << std::endl;
+                assert(overestimates == 0);
+            }
+        }
+    }
+}
+
+// True if `path` starts at `p.smallState`, each step is one blank move and
+// the last state is a goal.
+bool IsValidPath(const Problem& p, const std::vector<State>& path) {
+    if (path.empty() || path.front().small != p.smallState.small) return false;
+    const MoveTable<kDynamicGroupSize> moves(p);
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        const BlankMoves& m = moves[path[i - 1].zeroIndex];
+        bool legal = false;
+        for (std::uint32_t k = 0; k < m.count && !legal; ++k) {
+            if (m.to[k] != path[i].zeroIndex) continue;
+            State next = path[i - 1];
+            ApplyBlankMove(next, m.to[k]);
+            legal = next.small == path[i].small;
+        }
+        if (!legal) return false;
+    }
+    return path.back().IsGoal(p.n);
+}
+
+// Run every solver on random-walk instances: the optimal ones must return
+// valid paths of one cost, the hierarchical one a valid path no shorter.
+// Catches changes to shared code (move table, closed table, heuristics)
+// that break one engine but not the others.
+void RunSolverAgreementTests() {
+    const SolverKind optimal[] = {SolverKind::IDAStar, SolverKind::AStar, SolverKind::HDAStar,
+                                  SolverKind::Fringe,  SolverKind::BFHS,  SolverKind::EPEAStar};
+
+    std::mt19937 rng(356);
+    for (int n = 3; n <= 5; ++n) {
+        std::uniform_int_distribution<int> largeValue(1, n);
+        for (int instance = 0; instance < 4; ++instance) {
+            std::vector<Disk> large(RingSize(n));
+            for (Disk& d : large) d = static_cast<Disk>(largeValue(rng));
+            const Problem goal(large, MakeGoalState(0, n).small, static_cast<uint16_t>(n));
+
+            // Scramble with a random walk of the blank.
+            const int walk = 6 * n + 4 * instance;
+            const MoveTable<kDynamicGroupSize> moves(goal);
+            State start = goal.smallState;
+            for (int step = 0; step < walk; ++step) {
+                const BlankMoves& m = moves[start.zeroIndex];
+                ApplyBlankMove(start, m.to[std::uniform_int_distribution<std::uint32_t>(0, m.count - 1)(rng)]);
+            }
+            const Problem p(large, start.small, static_cast<uint16_t>(n));
+
+            HopConflictHeuristic heuristic;
+            SolveOptions opts;
+            opts.threads = 2;
+
+            std::cout << "[solvers] n=" << n << " instance=" << instance << " walk=" << walk;
+            long cost = -1;
+            bool agree = true;
+            for (SolverKind kind : optimal) {
+                opts.solver = kind;
+                const SolveResult result = SolveProblem(p, heuristic, opts);
+                const long moveCount = static_cast<long>(result.solution.size()) - 1;
+                std::cout << " " << ToString(kind) << "=" << moveCount;
+                if (cost < 0) cost = moveCount;
+                agree = agree && moveCount == cost && IsValidPath(p, result.solution);
+            }
+
+            opts.solver = SolverKind::Hierarchical;
+            const SolveResult hierarchical = SolveProblem(p, heuristic, opts);
+            const long hierarchicalCost = static_cast<long>(hierarchical.solution.size()) - 1;
+            const bool hierarchicalValid = IsValidPath(p, hierarchical.solution) && hierarchicalCost >= cost;
+            std::cout << " " << ToString(SolverKind::Hierarchical) << "=" << hierarchicalCost
+                      << " agree=" << (agree ? "yes" : "NO")
+                      << " hier_valid=" << (hierarchicalValid ? "yes" : "NO")
+                      << std::endl;
+            assert(agree);
+            assert(hierarchicalValid);
+        }
+    }
+}
+
 Problem GetDebugProblem() {
     // Default to a “harder” one so debug output is meaningful (as opposed to AB10 or AB17).
     return Problem(
@@ -110,35 +238,119 @@ Problem GetDebugProblem() {
         4);
 }
 
-int RunNormalMode(std::size_t num_large) {
-    Problem p = ReadUserInput(num_large);
+// Options for solving one instance from stdin.
+struct NormalOptions {
+    SolverKind solver = SolverKind::IDAStar;
+    CheckpointOptions checkpoint;
+    std::vector<PortfolioEntry> portfolio; // non-empty: race these instead of `solver`
+    std::string winnersPath;               // append a portfolio record here
+    std::string tracePath;                 // record a search trace here
+    bool perf = false;                     // report hardware counters to stderr
+};
 
-    // Default heuristic for stdin-driven mode.
-    HopHeuristic heuristic;
+int RunNormalMode(std::size_t num_large, const NormalOptions& options) {
+    // Other defaults (HopConflictHeuristic, no budget) come from SolveRequest.
+    SolveRequest request = ReadUserInput(num_large);
+    request.solver = options.solver;
+    request.checkpoint = options.checkpoint;
+    request.tracePath = options.tracePath;
+    request.perfCounters = options.perf;
+
+    SolveResponse response;
+    if (options.portfolio.empty()) {
+        response = Solve(request);
+    } else {
+        ABSolver solver;
+        PortfolioResponse race = SolvePortfolio(solver, request, options.portfolio);
+        if (!options.winnersPath.empty() && race.response.status != SolveStatus::InvalidInput) {
+            std::ofstream winners(options.winnersPath, std::ios::app);
+            AppendPortfolioRecord(winners, request, race);
+        }
+        response = std::move(race.response);
+    }
 
-    SolveOptions opts;
-    opts.solver = SolverKind::IDAStar;
-    opts.debug = false;
+    if (response.status == SolveStatus::InvalidInput) {
+        std::cerr << "Invalid instance: " << response.error << "\n";
+        return 1;
+    }
+    if (!response.error.empty()) {
+        std::cerr << "warning: " << response.error << "\n";
+    }
+    if (options.perf) {
+        WritePerfReport(std::cerr, response.perf, response.stats);
+    }
+    PrintSolution(response.path);
+    return 0;
+}
+
+// Whole-string integer option value in [min, max of T]. Prints a usage error
+// and returns false otherwise, instead of letting std::stoi throw.
+template <typename T>
+bool ParseCount(const std::string& flag, const std::string& text, T min, T& out) {
+    long long value = 0;
+    std::size_t used = 0;
+    try {
+        value = std::stoll(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size() || value < static_cast<long long>(min) ||
+        static_cast<unsigned long long>(value) > static_cast<unsigned long long>(std::numeric_limits<T>::max())) {
+        std::cerr << "Expected " << flag << " <integer >= " << min << ">, got '" << text << "'\n";
+        return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+}
 
-    std::vector<State> solution = SolveProblem(p, heuristic, opts);
-    PrintSolution(solution);
+// `AB --trace-report <file>`: summarize a trace written with --trace.
+int RunTraceReport(const std::string& path, std::size_t top) {
+    try {
+        TraceReader trace(path);
+        SummarizeTrace(trace, std::cout, top);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// `AB --profile <ring>`: large disks (and optionally a start state) on stdin.
+int RunProfileMode(std::size_t num_large, const ProfileOptions& options) {
+    SolveRequest request = ReadUserInput(num_large);
+    const int n = GroupSizeForRing(num_large);
+    if (!std::cin) {
+        // No start state given: predict from a goal state.
+        request.small = MakeGoalState(0, n).small;
+    }
+
+    const std::string error = ValidateRequest(request);
+    if (!error.empty()) {
+        std::cerr << "Invalid instance: " << error << "\n";
+        return 1;
+    }
+
+    const Problem p(request.large, request.small, static_cast<uint16_t>(n));
+    RunHeuristicProfile(p, options, std::cout);
     return 0;
 }
 
 int RunDebugMode() {
     // RunSanityTests();
+    RunHeuristicAdmissibilityTests();
+    RunSolverAgreementTests();
 
     Problem p = GetDebugProblem();
 
     // Use a stronger heuristic for debug mode by default.
-    HopHeuristic heuristic;
+    HopConflictHeuristic heuristic;
 
     SolveOptions opts;
     opts.solver = SolverKind::IDAStar;
     opts.debug = true;
 
-    std::vector<State> solution = SolveProblem(p, heuristic, opts);
-    PrintSolution(solution);
+    const SolveResult result = SolveProblem(p, heuristic, opts);
+    PrintSolution(result.solution);
     return 0;
 }
 
@@ -146,15 +358,131 @@ int RunDebugMode() {
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <n>\n"
+        std::cerr << "Usage: " << argv[0] << " <n> [--solver ida|astar|hda|fringe|bfhs|epea|hier]"
+                  << " [--checkpoint <file>] [--checkpoint-every <seconds>] [--resume]\n"
                   << "  n > 0: read instance from stdin (expects 2*n integers: large then small)\n"
-                  << "  n = 0: run debug mode (hardcoded instances + debug output)\n";
+                  << "       [--portfolio default|<solver>:<heuristic>,...] [--winners <file>] [--trace <file>] [--perf]\n"
+                  << "  --checkpoint saves IDA*/A* progress periodically; --resume continues from it\n"
+                  << "  --portfolio races the listed pairs on threads and prints the first answer\n"
+                  << "       " << argv[0] << " --portfolio-stats < <winners file>\n"
+                  << "  count how often each portfolio entry won\n"
+                  << "  --trace records every node the solver visits (see include/trace.h)\n"
+                  << "  --perf reports hardware counters per solver phase to stderr (see include/perf_counters.h)\n"
+                  << "       " << argv[0] << " --trace-report <file> [--top <k>]\n"
+                  << "  summarize a trace: nodes by depth and h, heuristic error hot spots, transpositions\n"
+                  << "  n = 0: run debug mode (hardcoded instances + debug output)\n"
+                  << "       " << argv[0] << " --serve [--socket <path>] [--workers <k>] [--cache <entries>] [--trace-dir <dir>]\n"
+                  << "  run as a service answering one request per line (see include/service.h)\n"
+                  << "       " << argv[0] << " --profile <n> [--depth <d>] [--states <s>] [--samples <k>] [--thresholds <t>]\n"
+                  << "  profile every heuristic on the layout read from stdin (see include/heuristic_profile.h)\n";
         return 1;
     }
 
+    if (std::string(argv[1]) == "--serve") {
+        ServiceOptions options;
+        for (int i = 2; i + 1 < argc; i += 2) {
+            const std::string flag = argv[i];
+            if (flag == "--socket") {
+                options.socketPath = argv[i + 1];
+            } else if (flag == "--workers") {
+                options.workers = static_cast<std::size_t>(std::stoul(argv[i + 1]));
+            } else if (flag == "--cache") {
+                options.cacheCapacity = static_cast<std::size_t>(std::stoul(argv[i + 1]));
+            } else if (flag == "--trace-dir") {
+                options.traceDir = argv[i + 1];
+            } else {
+                std::cerr << "Unknown option: " << flag << "\n";
+                return 1;
+            }
+        }
+        return RunService(options);
+    }
+
+    if (std::string(argv[1]) == "--portfolio-stats") {
+        SummarizePortfolioRecords(std::cin, std::cout);
+        return 0;
+    }
+
+    if (std::string(argv[1]) == "--trace-report" && argc >= 3) {
+        std::size_t top = 10;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            const std::string flag = argv[i];
+            if (flag == "--top") {
+                if (!ParseCount<std::size_t>(flag, argv[i + 1], 0, top)) return 1;
+            } else {
+                std::cerr << "Unknown option: " << flag << "\n";
+                return 1;
+            }
+        }
+        return RunTraceReport(argv[2], top);
+    }
+
+    if (std::string(argv[1]) == "--profile" && argc >= 3) {
+        ProfileOptions options;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            const std::string flag = argv[i];
+            bool ok = true;
+            if (flag == "--depth") {
+                ok = ParseCount(flag, argv[i + 1], 0, options.maxDepth);
+            } else if (flag == "--states") {
+                ok = ParseCount<std::size_t>(flag, argv[i + 1], 0, options.maxStates);
+            } else if (flag == "--samples") {
+                ok = ParseCount<std::size_t>(flag, argv[i + 1], 0, options.samples);
+            } else if (flag == "--thresholds") {
+                ok = ParseCount(flag, argv[i + 1], 1, options.thresholds);
+            } else {
+                std::cerr << "Unknown option: " << flag << "\n";
+                return 1;
+            }
+            if (!ok) return 1;
+        }
+        std::size_t ring = 0;
+        if (!ParseCount<std::size_t>("--profile", argv[2], 1, ring)) return 1;
+        return RunProfileMode(ring, options);
+    }
+
     const std::size_t n = static_cast<std::size_t>(std::stoi(argv[1]));
     if (n == 0) {
         return RunDebugMode();
     }
-    return RunNormalMode(n);
+
+    NormalOptions options;
+    CheckpointOptions& checkpoint = options.checkpoint;
+    for (int i = 2; i < argc; ++i) {
+        const std::string flag = argv[i];
+        if (flag == "--resume") {
+            checkpoint.resume = true;
+        } else if (flag == "--perf") {
+            options.perf = true;
+        } else if (i + 1 == argc) {
+            std::cerr << "Missing value for " << flag << "\n";
+            return 1;
+        } else if (flag == "--solver") {
+            if (!ParseSolverKind(argv[++i], options.solver)) {
+                std::cerr << "Expected --solver ida|astar|hda|fringe|bfhs|epea|hier after <n>\n";
+                return 1;
+            }
+        } else if (flag == "--checkpoint") {
+            checkpoint.path = argv[++i];
+        } else if (flag == "--checkpoint-every") {
+            checkpoint.interval = std::chrono::seconds(std::stoi(argv[++i]));
+        } else if (flag == "--portfolio") {
+            if (!ParsePortfolio(argv[++i], options.portfolio)) {
+                std::cerr << "Expected --portfolio default or <solver>:<heuristic>[,...]\n";
+                return 1;
+            }
+        } else if (flag == "--winners") {
+            options.winnersPath = argv[++i];
+        } else if (flag == "--trace") {
+            options.tracePath = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << flag << "\n";
+            return 1;
+        }
+    }
+    if (checkpoint.resume && !checkpoint.enabled()) {
+        std::cerr << "--resume needs --checkpoint <file>\n";
+        return 1;
+    }
+    return RunNormalMode(n, options);
 }
@@ -0,0 +1,30 @@
+#include "operator_table.h"
+#include "move_table.h"
+
+#include <cassert>
+
+void HopOperatorTable::Build(const Problem& p, const HopHeuristic& h) {
+    ring = static_cast<std::uint32_t>(p.large.size());
+    group = static_cast<std::uint32_t>(p.n);
+    assert(h.hops.RingSize() == ring);
+
+    const MoveTable<kDynamicGroupSize> moves(p);
+    const std::size_t rowLength = 2 * static_cast<std::size_t>(ring);
+    deltas.assign(static_cast<std::size_t>(ring) * 4 * rowLength, 0);
+
+    // Only block lower bounds (large rings) need row buffers.
+    std::vector<HopTable::Hops> blankScratch(h.hops.IsExact() ? 0 : rowLength);
+    std::vector<HopTable::Hops> toScratch(h.hops.IsExact() ? 0 : rowLength);
+    for (std::uint32_t blank = 0; blank < ring; ++blank) {
+        // The moved disc ends up where the blank was.
+        const HopTable::Hops* after = h.hops.SegmentRow(blank, blankScratch.data());
+        const BlankMoves& m = moves[blank];
+        for (std::uint32_t i = 0; i < m.count; ++i) {
+            const HopTable::Hops* before = h.hops.SegmentRow(m.to[i], toScratch.data());
+            Delta* row = &deltas[(static_cast<std::size_t>(blank) * 4 + i) * rowLength];
+            for (std::size_t k = 0; k < rowLength; ++k) {
+                row[k] = static_cast<Delta>(static_cast<int>(after[k]) - static_cast<int>(before[k]));
+            }
+        }
+    }
+}
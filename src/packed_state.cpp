@@ -0,0 +1,45 @@
+#include "packed_state.h"
+
+#include <cassert>
+
+unsigned BitsPerDisk(int n) {
+    assert(n > 0);
+    unsigned bits = 1;
+    while ((1u << bits) <= static_cast<unsigned>(n)) ++bits;
+    return bits;
+}
+
+PackedState::PackedState(const State& s, unsigned bitsPerDisk) {
+    const std::size_t perWord = 64 / bitsPerDisk;
+    words.assign(WordCount(s.small.size(), bitsPerDisk), 0);
+
+    for (std::size_t i = 0; i < s.small.size(); ++i) {
+        assert(s.small[i] < (1u << bitsPerDisk));
+        words[i / perWord] |= static_cast<std::uint64_t>(s.small[i]) << ((i % perWord) * bitsPerDisk);
+    }
+}
+
+State PackedState::Unpack(std::size_t ringSize, unsigned bitsPerDisk) const {
+    const std::size_t perWord = 64 / bitsPerDisk;
+    const std::uint64_t mask = (std::uint64_t(1) << bitsPerDisk) - 1;
+
+    State s;
+    s.small.resize(ringSize);
+    for (std::size_t i = 0; i < ringSize; ++i) {
+        s.small[i] = static_cast<Disk>((words[i / perWord] >> ((i % perWord) * bitsPerDisk)) & mask);
+    }
+    s.zeroIndex = s.GetZeroIndex();
+    return s;
+}
+
+/// Mixes each word (splitmix64 finalizer) into a running hash.
+std::size_t PackedState::Hash() const {
+    std::uint64_t h = words.size();
+    for (std::uint64_t w : words) {
+        w += 0x9e3779b97f4a7c15ULL + h;
+        w = (w ^ (w >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        w = (w ^ (w >> 27)) * 0x94d049bb133111ebULL;
+        h = w ^ (w >> 31);
+    }
+    return static_cast<std::size_t>(h);
+}
@@ -0,0 +1,211 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+thread_local PerfSession* currentSession = nullptr;
+
+const char* const kEventNames[4] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+
+// "1.23" for a ratio, "-" when the denominator is zero.
+std::string Ratio(double numerator, std::uint64_t denominator) {
+    if (denominator == 0) return "-";
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2f", numerator / static_cast<double>(denominator));
+    return text;
+}
+
+void WriteCounts(std::ostream& out, const PerfProfile& profile, const PerfCounts& c) {
+    const bool has[4] = {profile.hasCycles, profile.hasInstructions, profile.hasCacheMisses, profile.hasBranchMisses};
+    const std::uint64_t values[4] = {c.cycles, c.instructions, c.cacheMisses, c.branchMisses};
+    out << " nodes=" << c.nodes;
+    for (int e = 0; e < 4; ++e) {
+        if (has[e]) out << " " << kEventNames[e] << "=" << values[e];
+    }
+    if (profile.hasCycles && profile.hasInstructions) {
+        out << " ipc=" << Ratio(static_cast<double>(c.instructions), c.cycles);
+    }
+    if (c.nodes == 0) return;
+    for (int e = 0; e < 4; ++e) {
+        if (has[e] && e != 1) out << " " << kEventNames[e] << "/node=" << Ratio(static_cast<double>(values[e]), c.nodes);
+    }
+}
+
+#ifdef __linux__
+long OpenCounter(std::uint64_t config, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = groupFd == -1 ? 1 : 0; // the group starts with its leader
+    attr.exclude_kernel = 1;               // allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(SYS_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, groupFd, /*flags=*/0UL);
+}
+
+std::string OpenError(int error) {
+    if (error == ENOENT || error == EOPNOTSUPP) return "not supported by this CPU, kernel or hypervisor";
+    std::string reason = std::strerror(error);
+    if (error == EACCES || error == EPERM) reason += " (see /proc/sys/kernel/perf_event_paranoid)";
+    return reason;
+}
+#endif
+
+} // namespace
+
+void PerfCounts::Add(const PerfCounts& other) {
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cacheMisses += other.cacheMisses;
+    branchMisses += other.branchMisses;
+    scopes += other.scopes;
+    nodes += other.nodes;
+}
+
+const char* ToString(PerfPhase phase) {
+    switch (phase) {
+        case PerfPhase::HeuristicInit: return "heuristic-init";
+        case PerfPhase::IDAPass: return "ida-pass";
+        case PerfPhase::AStarExpand: return "astar-expand";
+        case PerfPhase::AStarProbe: return "astar-probe";
+    }
+    return "unknown";
+}
+
+PerfSession::PerfSession(PerfProfile* target) : outer(currentSession), profile(target) {
+    if (profile == nullptr) return;
+    *profile = PerfProfile();
+#ifdef __linux__
+    static const std::uint64_t configs[4] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                             PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    bool* has[4] = {&profile->hasCycles, &profile->hasInstructions, &profile->hasCacheMisses,
+                    &profile->hasBranchMisses};
+    int leader = -1;
+    int opened = 0;
+    for (int e = 0; e < 4; ++e) {
+        // An event the PMU lacks only drops that event; the first one to open leads the group.
+        const long fd = OpenCounter(configs[e], leader);
+        if (fd < 0) {
+            if (!profile->unavailable.empty()) profile->unavailable += "; ";
+            profile->unavailable += std::string(kEventNames[e]) + ": " + OpenError(errno);
+            continue;
+        }
+        fds[e] = static_cast<int>(fd);
+        slots[e] = opened++;
+        *has[e] = true;
+        if (leader == -1) leader = fds[e];
+    }
+    if (leader == -1) return;
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    profile->available = true;
+    currentSession = this;
+#else
+    profile->unavailable = "hardware counters need Linux perf_event_open";
+#endif
+}
+
+PerfSession::~PerfSession() {
+    if (currentSession == this) currentSession = outer;
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+PerfSession* PerfSession::Current() {
+    return currentSession;
+}
+
+bool PerfSession::Read(PerfCounts& out) const {
+#ifdef __linux__
+    int leader = -1;
+    for (int fd : fds) {
+        if (fd >= 0 && leader == -1) leader = fd;
+    }
+    if (leader == -1) return false;
+
+    // {nr, time_enabled, time_running, value[nr]}
+    std::uint64_t data[3 + 4];
+    const ssize_t got = read(leader, data, sizeof(data));
+    if (got < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || data[0] > 4) return false;
+
+    // A multiplexed group only counted for part of the time; scale up to all of it.
+    const std::uint64_t enabled = data[1];
+    const std::uint64_t running = data[2];
+    std::uint64_t* values[4] = {&out.cycles, &out.instructions, &out.cacheMisses, &out.branchMisses};
+    for (int e = 0; e < 4; ++e) {
+        if (slots[e] < 0 || static_cast<std::uint64_t>(slots[e]) >= data[0]) continue;
+        const std::uint64_t raw = data[3 + slots[e]];
+        *values[e] = running == 0 || running == enabled
+                         ? raw
+                         : static_cast<std::uint64_t>(static_cast<double>(raw) * enabled / running);
+    }
+    return true;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+void PerfScope::Begin() {
+    if (!session->Read(start)) session = nullptr;
+}
+
+void PerfScope::Finish(std::uint64_t nodes) {
+    PerfCounts end;
+    if (session->Read(end)) {
+        PerfCounts used;
+        used.cycles = end.cycles - start.cycles;
+        used.instructions = end.instructions - start.instructions;
+        used.cacheMisses = end.cacheMisses - start.cacheMisses;
+        used.branchMisses = end.branchMisses - start.branchMisses;
+        used.scopes = 1;
+        used.nodes = nodes;
+        PerfProfile& profile = session->Profile();
+        profile[phase].Add(used);
+        if (phase == PerfPhase::IDAPass) profile.passes.push_back(used);
+    }
+    session = nullptr;
+}
+
+void WritePerfReport(std::ostream& out, const PerfProfile& profile, const SearchStats& stats) {
+    if (!profile.available) {
+        out << "[perf] counters unavailable: " << profile.unavailable << "\n";
+        return;
+    }
+    if (!profile.unavailable.empty()) {
+        out << "[perf] some counters missing: " << profile.unavailable << "\n";
+    }
+    for (int i = 0; i < kPerfPhaseCount; ++i) {
+        const PerfPhase phase = static_cast<PerfPhase>(i);
+        const PerfCounts& c = profile[phase];
+        if (c.scopes == 0) continue;
+        out << "[perf] phase=" << ToString(phase) << " measured=" << c.scopes;
+        if (phase == PerfPhase::AStarExpand || phase == PerfPhase::AStarProbe) {
+            out << " sampled=1/" << kPerfSampleInterval;
+        }
+        WriteCounts(out, profile, c);
+        out << "\n";
+    }
+    for (std::size_t i = 0; i < profile.passes.size(); ++i) {
+        out << "[perf] ida-pass=" << i;
+        WriteCounts(out, profile, profile.passes[i]);
+        out << "\n";
+    }
+    out << "[perf] solve expanded=" << stats.expanded << " generated=" << stats.generated
+        << " iterations=" << stats.iterations << "\n";
+}
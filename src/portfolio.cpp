@@ -0,0 +1,199 @@
+#include "portfolio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t MicrosSince(Clock::time_point started) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count());
+}
+
+bool IsConclusive(SolveStatus status) {
+    return status == SolveStatus::Solved || status == SolveStatus::NoSolution;
+}
+
+/// FNV-1a over both rings, so records of the same instance can be matched up.
+std::string InstanceKey(const SolveRequest& request) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (const std::vector<Disk>* ring : {&request.large, &request.small}) {
+        for (Disk d : *ring) {
+            h ^= d;
+            h *= 0x100000001b3ULL;
+        }
+    }
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(h));
+    return buffer;
+}
+
+// Value of `key=` in a record line, or empty.
+std::string Field(const std::string& line, const std::string& key) {
+    std::istringstream in(line);
+    std::string token;
+    while (in >> token) {
+        if (token.compare(0, key.size() + 1, key + "=") == 0) return token.substr(key.size() + 1);
+    }
+    return std::string();
+}
+
+} // namespace
+
+std::vector<PortfolioEntry> DefaultPortfolio() {
+    return {
+        {SolverKind::Fringe, HeuristicKind::HopConflict},
+        {SolverKind::AStar, HeuristicKind::Hop},
+        {SolverKind::IDAStar, HeuristicKind::HopConflict},
+    };
+}
+
+bool ParsePortfolio(const std::string& spec, std::vector<PortfolioEntry>& out) {
+    if (spec == "default") {
+        out = DefaultPortfolio();
+        return true;
+    }
+
+    std::vector<PortfolioEntry> entries;
+    std::istringstream in(spec);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const std::size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        PortfolioEntry entry;
+        if (!ParseSolverKind(item.substr(0, colon), entry.solver) ||
+            !ParseHeuristicKind(item.substr(colon + 1), entry.heuristic)) {
+            return false;
+        }
+        // The first answer wins the race, so a suboptimal racer would win with a worse one.
+        if (entry.solver == SolverKind::Hierarchical) return false;
+        entries.push_back(entry);
+    }
+    if (entries.empty()) return false;
+    out = entries;
+    return true;
+}
+
+std::string ToString(const PortfolioEntry& entry) {
+    return std::string(ToString(entry.solver)) + ":" + ToString(entry.heuristic);
+}
+
+PortfolioResponse SolvePortfolio(ABSolver& solver, const SolveRequest& request,
+                                 const std::vector<PortfolioEntry>& entries) {
+    PortfolioResponse result;
+    result.response.error = entries.empty() ? "empty portfolio" : ValidateRequest(request);
+    if (!result.response.error.empty()) {
+        result.response.status = SolveStatus::InvalidInput;
+        return result;
+    }
+
+    const Clock::time_point started = Clock::now();
+    // Cancelled by the winner, or along with the caller's token.
+    CancellationToken raceOver(request.cancel);
+    std::mutex mutex;
+    std::vector<SolveResponse> responses(entries.size());
+
+    auto race = [&](std::size_t i) {
+        SolveRequest own = request;
+        own.solver = entries[i].solver;
+        own.heuristic = entries[i].heuristic;
+        own.cancel = &raceOver;
+        own.checkpoint = CheckpointOptions(); // racers would overwrite each other's file
+        own.tracePath.clear();
+
+        SolveResponse response = solver.Solve(own);
+        // Racers start at slightly different times; compare them from the start of the race.
+        response.elapsedMicros = MicrosSince(started);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (IsConclusive(response.status) && result.winner < 0) {
+            result.winner = static_cast<int>(i);
+            raceOver.Cancel();
+        }
+        responses[i] = std::move(response);
+    };
+
+    std::vector<std::thread> racers;
+    for (std::size_t i = 1; i < entries.size(); ++i) racers.emplace_back(race, i);
+    race(0);
+    for (std::thread& t : racers) t.join();
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        result.outcomes.push_back(
+            PortfolioOutcome{entries[i], responses[i].status, responses[i].elapsedMicros, responses[i].stats});
+    }
+
+    if (result.winner >= 0) {
+        result.response = std::move(responses[result.winner]);
+        return result;
+    }
+
+    // Nobody finished: report the request's own limit (or a shared input error).
+    const auto failed = [](const SolveResponse& r) { return r.status == SolveStatus::InvalidInput; };
+    if (std::all_of(responses.begin(), responses.end(), failed)) {
+        result.response = std::move(responses[0]);
+        return result;
+    }
+    const bool cancelled = request.cancel != nullptr && request.cancel->IsCancelled();
+    result.response.status = cancelled ? SolveStatus::Cancelled : SolveStatus::BudgetExceeded;
+    result.response.elapsedMicros = MicrosSince(started);
+    return result;
+}
+
+void AppendPortfolioRecord(std::ostream& out, const SolveRequest& request, const PortfolioResponse& result) {
+    out << "instance=" << InstanceKey(request)
+        << " ring=" << request.large.size()
+        << " winner=" << (result.winner >= 0 ? ToString(result.outcomes[result.winner].entry) : std::string("none"))
+        << " moves=" << result.response.moves.size()
+        << " time_us=" << result.response.elapsedMicros;
+    for (const PortfolioOutcome& outcome : result.outcomes) {
+        out << " " << ToString(outcome.entry) << "=" << ToString(outcome.status) << ":" << outcome.elapsedMicros;
+    }
+    out << "\n";
+}
+
+void SummarizePortfolioRecords(std::istream& in, std::ostream& out) {
+    struct Tally {
+        std::uint64_t wins = 0;
+        std::uint64_t winMicros = 0;
+    };
+    std::map<std::string, Tally> tallies;
+    std::uint64_t races = 0;
+    std::uint64_t unsolved = 0;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::string winner = Field(line, "winner");
+        if (winner.empty()) continue;
+        ++races;
+        if (winner == "none") {
+            ++unsolved;
+            continue;
+        }
+        Tally& tally = tallies[winner];
+        ++tally.wins;
+        tally.winMicros += std::strtoull(Field(line, "time_us").c_str(), nullptr, 10);
+    }
+
+    std::vector<std::pair<std::string, Tally>> ranked(tallies.begin(), tallies.end());
+    std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<std::string, Tally>& a,
+                                                      const std::pair<std::string, Tally>& b) {
+        return a.second.wins > b.second.wins;
+    });
+
+    out << "[portfolio] races=" << races << " unsolved=" << unsolved << "\n";
+    for (const auto& entry : ranked) {
+        out << "[portfolio] entry=" << entry.first
+            << " wins=" << entry.second.wins
+            << " share=" << static_cast<double>(entry.second.wins) / races
+            << " mean_win_us=" << entry.second.winMicros / entry.second.wins
+            << "\n";
+    }
+}
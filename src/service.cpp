@@ -0,0 +1,403 @@
+#include "service.h"
+#include "absolver.h"
+#include "group_size.h"
+#include "portfolio.h"
+#include "solve.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// ---------------------------- Responses ----------------------------
+
+// Where the responses for one client go. Writes are whole lines and may come
+// from several workers at once.
+class ResponseSink {
+  public:
+    virtual ~ResponseSink() = default;
+    virtual void WriteLine(const std::string& line) = 0;
+};
+
+class StdoutSink : public ResponseSink {
+    std::mutex mutex;
+
+  public:
+    void WriteLine(const std::string& line) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::cout << line << '\n' << std::flush;
+    }
+};
+
+#ifndef _WIN32
+// One accepted connection. The descriptor is closed once the reader and every
+// pending job have let go of the sink.
+class SocketSink : public ResponseSink {
+    int fd;
+    std::mutex mutex;
+
+  public:
+    explicit SocketSink(int descriptor) : fd(descriptor) {}
+    ~SocketSink() override { ::close(fd); }
+
+    void WriteLine(const std::string& line) override {
+        const std::string data = line + '\n';
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const char* next = data.data();
+        std::size_t left = data.size();
+        while (left > 0) {
+            const ssize_t written = ::write(fd, next, left);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return; // client went away; drop the response
+            }
+            next += written;
+            left -= static_cast<std::size_t>(written);
+        }
+    }
+};
+#endif
+
+// ---------------------------- Jobs ----------------------------
+
+struct Job {
+    std::string line;
+    std::shared_ptr<ResponseSink> sink;
+    Clock::time_point received;
+};
+
+// FIFO shared by the readers and the worker pool.
+class JobQueue {
+    std::deque<Job> jobs;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool closed = false;
+
+  public:
+    void Push(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        ready.notify_one();
+    }
+
+    // Blocks until a job is available. Returns false once closed and drained.
+    bool Pop(Job& out) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !jobs.empty(); });
+        if (jobs.empty()) return false;
+        out = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+};
+
+// ---------------------------- Requests ----------------------------
+
+struct Request {
+    std::string id;
+    SolveRequest solve;
+    long timeBudgetMs = 0; // 0 = unlimited; counted from when the line was read
+    std::vector<PortfolioEntry> portfolio; // non-empty: race these instead of solve.solver
+    bool trace = false;                    // write <trace dir>/<id>.abtrace
+};
+
+bool ReadDisks(std::istringstream& in, std::size_t count, std::vector<Disk>& out) {
+    out.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        int value;
+        if (!(in >> value) || value < 0 || value > 255) return false;
+        out[i] = static_cast<Disk>(value);
+    }
+    return true;
+}
+
+bool ParseRequest(const std::string& line, Request& req, std::string& error) {
+    std::istringstream in(line);
+    if (!(in >> req.id)) {
+        error = "empty request";
+        return false;
+    }
+
+    long ring = 0;
+    if (!(in >> ring) || ring < 5 || ring > static_cast<long>(RingSize(kMaxGroupSize))) {
+        error = "expected ring size (5.." + std::to_string(RingSize(kMaxGroupSize)) + ")";
+        return false;
+    }
+    if (RingSize(GroupSizeForRing(static_cast<std::size_t>(ring))) != static_cast<std::uint32_t>(ring)) {
+        error = "ring size must be n*n+1";
+        return false;
+    }
+    if (!ReadDisks(in, static_cast<std::size_t>(ring), req.solve.large) ||
+        !ReadDisks(in, static_cast<std::size_t>(ring), req.solve.small)) {
+        error = "expected " + std::to_string(ring) + " large and " + std::to_string(ring) + " small disks";
+        return false;
+    }
+
+    std::string option;
+    while (in >> option) {
+        const std::size_t eq = option.find('=');
+        const std::string key = option.substr(0, eq);
+        const std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+
+        if (key == "solver") {
+            if (!ParseSolverKind(value, req.solve.solver)) {
+                error = "unknown solver '" + value + "'";
+                return false;
+            }
+        } else if (key == "heuristic") {
+            if (!ParseHeuristicKind(value, req.solve.heuristic)) {
+                error = "unknown heuristic '" + value + "'";
+                return false;
+            }
+        } else if (key == "threads") {
+            try {
+                req.solve.threads = static_cast<unsigned>(std::stoul(value));
+            } catch (const std::exception&) {
+                error = "bad threads '" + value + "'";
+                return false;
+            }
+        } else if (key == "portfolio") {
+            if (!ParsePortfolio(value, req.portfolio)) {
+                error = "bad portfolio '" + value + "'";
+                return false;
+            }
+        } else if (key == "trace") {
+            req.trace = value == "1";
+        } else if (key == "time_ms") {
+            try {
+                req.timeBudgetMs = std::stol(value);
+            } catch (const std::exception&) {
+                error = "bad time_ms '" + value + "'";
+                return false;
+            }
+        } else {
+            error = "unknown option '" + key + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+void AppendState(std::string& out, const State& s) {
+    for (std::size_t i = 0; i < s.small.size(); ++i) {
+        if (i > 0) out += ',';
+        out += std::to_string(static_cast<int>(s.small[i]));
+    }
+}
+
+std::string HandleRequest(const Job& job, ABSolver& solver, const std::string& traceDir) {
+    Request req;
+    std::string error;
+    if (!ParseRequest(job.line, req, error)) {
+        return (req.id.empty() ? std::string("-") : req.id) + " error " + error;
+    }
+    if (req.trace) {
+        if (traceDir.empty()) return req.id + " error tracing is off (start with --trace-dir)";
+        if (req.id.find('/') != std::string::npos || req.id[0] == '.') {
+            return req.id + " error id unusable as a trace file name";
+        }
+        if (!req.portfolio.empty()) return req.id + " error trace and portfolio cannot be combined";
+        req.solve.tracePath = traceDir + "/" + req.id + ".abtrace";
+    }
+
+    if (req.timeBudgetMs > 0) {
+        // The budget started when the line was read, not when a worker got to it.
+        const auto queued = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - job.received);
+        req.solve.timeBudget = std::max(std::chrono::milliseconds(req.timeBudgetMs) - queued, std::chrono::milliseconds(1));
+    }
+    std::string winner;
+    SolveResponse result;
+    if (req.portfolio.empty()) {
+        result = solver.Solve(req.solve);
+    } else {
+        PortfolioResponse race = SolvePortfolio(solver, req.solve, req.portfolio);
+        if (race.winner >= 0) winner = " winner=" + ToString(req.portfolio[race.winner]);
+        result = std::move(race.response);
+    }
+
+    const long long micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - job.received).count();
+    const std::string timing = " time_us=" + std::to_string(micros);
+
+    switch (result.status) {
+        case SolveStatus::InvalidInput: return req.id + " error " + result.error;
+        case SolveStatus::Cancelled:
+        case SolveStatus::BudgetExceeded: return req.id + " timeout" + timing;
+        case SolveStatus::NoSolution: return req.id + " nosolution" + timing + winner;
+        case SolveStatus::Solved: break;
+    }
+
+    std::string response = req.id + " solved moves=" + std::to_string(result.moves.size()) + timing + winner + " path=";
+    for (std::size_t i = 0; i < result.path.size(); ++i) {
+        if (i > 0) response += ';';
+        AppendState(response, result.path[i]);
+    }
+    return response;
+}
+
+// ---------------------------- Worker pool ----------------------------
+
+class WorkerPool {
+    std::vector<std::thread> threads;
+
+  public:
+    WorkerPool(std::size_t count, JobQueue& queue, ABSolver& solver, const std::string& traceDir) {
+        for (std::size_t i = 0; i < count; ++i) {
+            threads.emplace_back([&queue, &solver, &traceDir] {
+                Job job;
+                while (queue.Pop(job)) {
+                    job.sink->WriteLine(HandleRequest(job, solver, traceDir));
+                    job.sink.reset();
+                }
+            });
+        }
+    }
+
+    void Join() {
+        for (std::thread& t : threads) t.join();
+    }
+};
+
+std::size_t WorkerCount(const ServiceOptions& options) {
+    if (options.workers > 0) return options.workers;
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+bool IsBlank(const std::string& line) {
+    return line.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+int RunStdinService(JobQueue& queue) {
+    std::shared_ptr<ResponseSink> sink = std::make_shared<StdoutSink>();
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (IsBlank(line)) continue;
+        queue.Push(Job{line, sink, Clock::now()});
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+void ReadConnection(int fd, JobQueue& queue) {
+    std::shared_ptr<ResponseSink> sink = std::make_shared<SocketSink>(fd);
+    std::string pending;
+    char buffer[4096];
+
+    while (true) {
+        const ssize_t got = ::read(fd, buffer, sizeof(buffer));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+
+        pending.append(buffer, static_cast<std::size_t>(got));
+        std::size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (!IsBlank(line)) queue.Push(Job{line, sink, Clock::now()});
+        }
+    }
+    if (!IsBlank(pending)) queue.Push(Job{pending, sink, Clock::now()});
+}
+
+int RunSocketService(const std::string& path, JobQueue& queue) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return 1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Replace a stale socket from an earlier run, but never any other file.
+    struct stat existing;
+    if (::stat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << path << " exists and is not a socket\n";
+            return 1;
+        }
+        ::unlink(path.c_str());
+    }
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener, 64) != 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    while (true) {
+        const int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "accept failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        std::thread(ReadConnection, fd, std::ref(queue)).detach();
+    }
+
+    ::close(listener);
+    return 1;
+}
+#endif
+
+} // namespace
+
+int RunService(const ServiceOptions& options) {
+    JobQueue queue;
+    ABSolver solver(options.cacheCapacity);
+    WorkerPool pool(WorkerCount(options), queue, solver, options.traceDir);
+
+    int status;
+    if (options.socketPath.empty()) {
+        status = RunStdinService(queue);
+    } else {
+#ifndef _WIN32
+        status = RunSocketService(options.socketPath, queue);
+#else
+        std::cerr << "Socket mode is not supported on Windows; use stdin/stdout.\n";
+        status = 1;
+#endif
+    }
+
+    queue.Close();
+    pool.Join();
+    return status;
+}
@@ -0,0 +1,88 @@
+#include "solvability.h"
+#include "group_size.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// True if every colour 1..n appears exactly n times and there is exactly one blank.
+bool HasGoalColourCounts(const State& s, int n) {
+    std::vector<std::size_t> counts(static_cast<std::size_t>(n) + 1, 0);
+    for (Disk d : s.small) {
+        if (d > n) return false;
+        ++counts[d];
+    }
+
+    if (counts[0] != 1) return false;
+    for (int colour = 1; colour <= n; ++colour) {
+        if (counts[static_cast<std::size_t>(colour)] != static_cast<std::size_t>(n)) return false;
+    }
+    return true;
+}
+
+// True if the discs, read around the ring from the blank, are a rotation of
+// the goal order 1..1 2..2 ... n..n.
+bool MatchesGoalCyclicOrder(const State& s, int n) {
+    const std::size_t total = s.small.size();
+    const std::size_t discs = total - 1;
+
+    std::vector<Disk> order;
+    order.reserve(discs);
+    for (std::size_t i = 1; i < total; ++i) {
+        order.push_back(s.small[(s.zeroIndex + i) % total]);
+    }
+
+    // The goal order starts at the one place where colour n is followed by colour 1.
+    std::size_t start = discs;
+    for (std::size_t i = 0; i < discs; ++i) {
+        if (order[i] == 1 && order[(i + discs - 1) % discs] == n) {
+            start = i;
+            break;
+        }
+    }
+    if (start == discs) return false;
+
+    for (std::size_t i = 0; i < discs; ++i) {
+        if (order[(start + i) % discs] != static_cast<Disk>(i / n + 1)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+Solvability AnalyzeSolvability(const Problem& p) {
+    const State& start = p.smallState;
+    const int n = p.n;
+    const std::size_t total = p.large.size();
+
+    if (n < 2 || total != RingSize(n) || start.small.size() != total) {
+        return Solvability::Unknown;
+    }
+    if (!HasGoalColourCounts(start, n)) {
+        return Solvability::Unsolvable;
+    }
+    if (start.IsGoal(n)) {
+        return Solvability::Solvable;
+    }
+
+    for (Disk large : p.large) {
+        const std::size_t jump = large % total;
+        const std::size_t effective = jump < total - jump ? jump : total - jump;
+        if (effective >= 2) {
+            return Solvability::Solvable;
+        }
+    }
+
+    return MatchesGoalCyclicOrder(start, n) ? Solvability::Solvable : Solvability::Unsolvable;
+}
+
+const char* ToString(Solvability s) {
+    switch (s) {
+        case Solvability::Unsolvable: return "unsolvable";
+        case Solvability::Solvable: return "solvable";
+        case Solvability::Unknown: return "unknown";
+    }
+    return "unknown";
+}
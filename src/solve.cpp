@@ -0,0 +1,114 @@
+#include "solve.h"
+
+SolveResult SolveProblem(const Problem& p, Heuristic& heuristic, HeuristicKind kind, const SolveOptions& opts) {
+    switch (kind) {
+        case HeuristicKind::Zero:
+            return SolveProblem(p, static_cast<ZeroHeuristic&>(heuristic), opts);
+        case HeuristicKind::MisplacedDisc:
+            return SolveProblem(p, static_cast<MisplacedDiscHeuristic&>(heuristic), opts);
+        case HeuristicKind::Hop:
+            return SolveProblem(p, static_cast<HopHeuristic&>(heuristic), opts);
+        case HeuristicKind::HopConflict:
+            return SolveProblem(p, static_cast<HopConflictHeuristic&>(heuristic), opts);
+    }
+    return SolveProblem(p, heuristic, opts);
+}
+
+namespace {
+
+template <typename HeuristicT>
+std::vector<HeuristicT*> Downcast(const std::vector<Heuristic*>& heuristics) {
+    std::vector<HeuristicT*> out;
+    out.reserve(heuristics.size());
+    for (Heuristic* h : heuristics) out.push_back(static_cast<HeuristicT*>(h));
+    return out;
+}
+
+} // namespace
+
+std::vector<SolveResult> SolveInterleaved(const std::vector<Problem>& problems,
+                                          const std::vector<Heuristic*>& heuristics,
+                                          HeuristicKind kind,
+                                          const std::vector<SearchLimits>& limits,
+                                          bool debug) {
+    switch (kind) {
+        case HeuristicKind::Zero:
+            return SolveInterleaved(problems, Downcast<ZeroHeuristic>(heuristics), limits, debug);
+        case HeuristicKind::MisplacedDisc:
+            return SolveInterleaved(problems, Downcast<MisplacedDiscHeuristic>(heuristics), limits, debug);
+        case HeuristicKind::Hop:
+            return SolveInterleaved(problems, Downcast<HopHeuristic>(heuristics), limits, debug);
+        case HeuristicKind::HopConflict:
+            return SolveInterleaved(problems, Downcast<HopConflictHeuristic>(heuristics), limits, debug);
+    }
+    return SolveInterleaved(problems, heuristics, limits, debug);
+}
+
+std::unique_ptr<Heuristic> MakeHeuristic(HeuristicKind kind) {
+    switch (kind) {
+        case HeuristicKind::Zero: return std::unique_ptr<Heuristic>(new ZeroHeuristic());
+        case HeuristicKind::MisplacedDisc: return std::unique_ptr<Heuristic>(new MisplacedDiscHeuristic());
+        case HeuristicKind::Hop: return std::unique_ptr<Heuristic>(new HopHeuristic());
+        case HeuristicKind::HopConflict: return std::unique_ptr<Heuristic>(new HopConflictHeuristic());
+    }
+    return nullptr;
+}
+
+bool ParseSolverKind(const std::string& name, SolverKind& out) {
+    if (name == "ida") {
+        out = SolverKind::IDAStar;
+    } else if (name == "astar") {
+        out = SolverKind::AStar;
+    } else if (name == "hda") {
+        out = SolverKind::HDAStar;
+    } else if (name == "fringe") {
+        out = SolverKind::Fringe;
+    } else if (name == "bfhs") {
+        out = SolverKind::BFHS;
+    } else if (name == "epea") {
+        out = SolverKind::EPEAStar;
+    } else if (name == "hier") {
+        out = SolverKind::Hierarchical;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ToString(SolverKind kind) {
+    switch (kind) {
+        case SolverKind::IDAStar: return "ida";
+        case SolverKind::AStar: return "astar";
+        case SolverKind::HDAStar: return "hda";
+        case SolverKind::Fringe: return "fringe";
+        case SolverKind::BFHS: return "bfhs";
+        case SolverKind::EPEAStar: return "epea";
+        case SolverKind::Hierarchical: return "hier";
+    }
+    return "unknown";
+}
+
+bool ParseHeuristicKind(const std::string& name, HeuristicKind& out) {
+    if (name == "zero") {
+        out = HeuristicKind::Zero;
+    } else if (name == "misplaced") {
+        out = HeuristicKind::MisplacedDisc;
+    } else if (name == "hop") {
+        out = HeuristicKind::Hop;
+    } else if (name == "hop-conflict") {
+        out = HeuristicKind::HopConflict;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ToString(HeuristicKind kind) {
+    switch (kind) {
+        case HeuristicKind::Zero: return "zero";
+        case HeuristicKind::MisplacedDisc: return "misplaced";
+        case HeuristicKind::Hop: return "hop";
+        case HeuristicKind::HopConflict: return "hop-conflict";
+    }
+    return "unknown";
+}
@@ -1,5 +1,6 @@
 #include "state.h"
 #include "common.h"
+#include "group_size.h"
 
 #include <cassert>
 #include <cstdint>
@@ -26,6 +27,36 @@ bool State::IsGoal(int n) const
     return true;
 }
 
+template <int N>
+bool State::IsGoal(int n) const
+{
+    if (N == kDynamicGroupSize) { return IsGoal(n); }
+
+    assert(small.size() == RingSize(N));
+    assert(small[zeroIndex] == 0);
+
+    constexpr int total = static_cast<int>(RingSize(N));
+    constexpr int goalCount = N * N;
+
+    // Same walk as IsGoal(n), with the modulo replaced by a single wrap.
+    int index = static_cast<int>(zeroIndex) + 1;
+    for (int i = 0; i < goalCount; ++i, ++index)
+    {
+        if (index == total) { index = 0; }
+        const int expected = (i / (N > 0 ? N : 1)) + 1;
+        if (small[static_cast<std::size_t>(index)] != static_cast<Disk>(expected))
+            return false;
+    }
+    return true;
+}
+
+template bool State::IsGoal<kDynamicGroupSize>(int) const;
+template bool State::IsGoal<2>(int) const;
+template bool State::IsGoal<3>(int) const;
+template bool State::IsGoal<4>(int) const;
+template bool State::IsGoal<5>(int) const;
+template bool State::IsGoal<6>(int) const;
+
 std::uint32_t State::GetZeroIndex() const
 {
     for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(small.size()); ++i)
@@ -0,0 +1,242 @@
+#include "trace.h"
+
+#include "closed_table.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const char kTraceMagic[9] = "ABTRACE2";
+const char kTraceMagicV1[9] = "ABTRACE1"; // 16-bit g and h, 8-bit blank positions
+
+const char* ToString(TraceEvent event) {
+    switch (event) {
+        case TraceEvent::Expanded: return "expanded";
+        case TraceEvent::Pruned: return "pruned";
+        case TraceEvent::Duplicate: return "duplicate";
+        case TraceEvent::Reopened: return "reopened";
+        case TraceEvent::Goal: return "goal";
+        case TraceEvent::Bound: return "bound";
+    }
+    return "unknown";
+}
+
+constexpr std::size_t kEventCount = static_cast<std::size_t>(TraceEvent::Bound) + 1;
+
+std::string Hex(std::uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+template <typename T>
+void Put(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool Get(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} // namespace
+
+TraceRecorder::TraceRecorder(const std::string& path, std::size_t ringSize, const std::string& label)
+    : out(path, std::ios::binary | std::ios::trunc) {
+    out.write(kTraceMagic, 8);
+    Put(out, static_cast<std::uint32_t>(ringSize));
+    Put(out, static_cast<std::uint32_t>(label.size()));
+    out.write(label.data(), static_cast<std::streamsize>(label.size()));
+}
+
+bool TraceRecorder::Good() {
+    std::lock_guard<std::mutex> lock(mutex);
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+void TraceRecorder::Write(std::uint32_t thread, const TraceRecord* records, std::size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Put(out, thread);
+    Put(out, static_cast<std::uint32_t>(count));
+    out.write(reinterpret_cast<const char*>(records), static_cast<std::streamsize>(count * sizeof(TraceRecord)));
+}
+
+TraceBuffer::TraceBuffer(TraceRecorder* r, std::uint32_t t)
+    : recorder(r), thread(t), records(r != nullptr ? new TraceRecord[kCapacity] : nullptr) {}
+
+void TraceBuffer::Append(const State& s, int g, int h, std::uint32_t from, TraceEvent event) {
+    if (used == kCapacity) Flush();
+    TraceRecord& r = records[used++];
+    r.stateHash = ClosedTable::HashOf(s);
+    r.g = g;
+    r.h = h;
+    r.from = static_cast<std::uint16_t>(from);
+    r.to = static_cast<std::uint16_t>(s.zeroIndex);
+    r.event = event;
+    r.reserved[0] = r.reserved[1] = r.reserved[2] = 0;
+}
+
+void TraceBuffer::RecordBound(int threshold) {
+    if (recorder == nullptr) return;
+    if (used == kCapacity) Flush();
+    records[used++] = TraceRecord{0, 0, threshold, kTraceNoMove, kTraceNoMove, TraceEvent::Bound, {0, 0, 0}};
+}
+
+void TraceBuffer::Flush() {
+    if (recorder == nullptr || used == 0) return;
+    recorder->Write(thread, records.get(), used);
+    used = 0;
+}
+
+TraceReader::TraceReader(const std::string& path) : in(path, std::ios::binary) {
+    char magic[8];
+    std::uint32_t ring = 0, labelSize = 0;
+    if (!in.read(magic, 8)) {
+        throw std::runtime_error("not a trace file: " + path);
+    }
+    if (std::memcmp(magic, kTraceMagicV1, 8) == 0) {
+        throw std::runtime_error("trace file from an older version (ABTRACE1), record it again: " + path);
+    }
+    if (std::memcmp(magic, kTraceMagic, 8) != 0 || !Get(in, ring) || !Get(in, labelSize)) {
+        throw std::runtime_error("not a trace file: " + path);
+    }
+    traceLabel.resize(labelSize);
+    if (labelSize > 0 && !in.read(&traceLabel[0], labelSize)) {
+        throw std::runtime_error("truncated trace file: " + path);
+    }
+    ringSize = ring;
+}
+
+bool TraceReader::Next(std::uint32_t& thread, TraceRecord& record) {
+    while (chunkLeft == 0) {
+        if (!Get(in, chunkThread) || !Get(in, chunkLeft)) return false;
+    }
+    if (!Get(in, record)) return false; // a chunk cut short by a crash
+    --chunkLeft;
+    thread = chunkThread;
+    return true;
+}
+
+void SummarizeTrace(TraceReader& trace, std::ostream& out, std::size_t top) {
+    struct DepthCounts {
+        std::uint64_t expanded = 0;
+        std::uint64_t pruned = 0;
+    };
+    struct StateCounts {
+        std::uint64_t expanded = 0;
+        int minG = std::numeric_limits<int>::max();
+    };
+
+    std::uint64_t records = 0;
+    std::uint64_t events[kEventCount] = {};
+    std::map<std::uint32_t, std::uint64_t> perThread;
+    std::map<int, DepthCounts> byDepth;
+    std::map<std::pair<int, int>, std::uint64_t> cells; // (g, h) -> expansions
+    int goalCost = std::numeric_limits<int>::max();
+
+    // Expansions per state, over the whole trace and within the current pass of each thread.
+    std::unordered_map<std::uint64_t, StateCounts> states;
+    std::map<std::uint32_t, std::unordered_map<std::uint64_t, std::uint32_t>> passes;
+    std::uint64_t repeatedInPass = 0;
+
+    std::uint32_t thread = 0;
+    TraceRecord r;
+    while (trace.Next(thread, r)) {
+        ++records;
+        ++perThread[thread];
+        const std::size_t event = static_cast<std::size_t>(r.event);
+        if (event >= kEventCount) continue;
+        ++events[event];
+
+        switch (r.event) {
+            case TraceEvent::Expanded: {
+                ++byDepth[r.g].expanded;
+                ++cells[std::make_pair(static_cast<int>(r.g), static_cast<int>(r.h))];
+                StateCounts& counts = states[r.stateHash];
+                ++counts.expanded;
+                counts.minG = std::min(counts.minG, static_cast<int>(r.g));
+                if (passes[thread][r.stateHash]++ > 0) ++repeatedInPass;
+                break;
+            }
+            case TraceEvent::Pruned: ++byDepth[r.g].pruned; break;
+            case TraceEvent::Goal: goalCost = std::min(goalCost, static_cast<int>(r.g)); break;
+            case TraceEvent::Bound: passes[thread].clear(); break;
+            case TraceEvent::Duplicate:
+            case TraceEvent::Reopened: break;
+        }
+    }
+
+    out << "[trace] label=" << trace.label() << " ring=" << trace.ring() << " records=" << records
+        << " threads=" << perThread.size() << "\n";
+    for (std::size_t e = 0; e < kEventCount; ++e) {
+        out << "[trace] event=" << ToString(static_cast<TraceEvent>(e)) << " count=" << events[e] << "\n";
+    }
+    if (perThread.size() > 1) {
+        for (const auto& entry : perThread) {
+            out << "[trace] thread=" << entry.first << " records=" << entry.second << "\n";
+        }
+    }
+    for (const auto& entry : byDepth) {
+        out << "[trace] depth=" << entry.first << " expanded=" << entry.second.expanded
+            << " pruned=" << entry.second.pruned << "\n";
+    }
+
+    // By h, with the mean slack once the goal cost is known.
+    const bool solved = goalCost != std::numeric_limits<int>::max();
+    std::map<int, std::pair<std::uint64_t, std::uint64_t>> byH; // h -> (expansions, slack sum)
+    std::vector<std::pair<std::uint64_t, std::pair<int, int>>> hotSpots;
+    for (const auto& cell : cells) {
+        const int g = cell.first.first, h = cell.first.second;
+        const int slack = solved ? std::max(goalCost - g - h, 0) : 0;
+        auto& entry = byH[h];
+        entry.first += cell.second;
+        entry.second += cell.second * static_cast<std::uint64_t>(slack);
+        if (slack > 0) hotSpots.emplace_back(cell.second * static_cast<std::uint64_t>(slack), cell.first);
+    }
+    for (const auto& entry : byH) {
+        out << "[trace] h=" << entry.first << " expanded=" << entry.second.first;
+        if (solved) out << " mean_slack=" << static_cast<double>(entry.second.second) / entry.second.first;
+        out << "\n";
+    }
+
+    if (solved) {
+        out << "[trace] goal_cost=" << goalCost << "\n";
+        std::stable_sort(hotSpots.begin(), hotSpots.end(), [](const std::pair<std::uint64_t, std::pair<int, int>>& a,
+                                                              const std::pair<std::uint64_t, std::pair<int, int>>& b) {
+            return a.first > b.first;
+        });
+        for (std::size_t i = 0; i < hotSpots.size() && i < top; ++i) {
+            const int g = hotSpots[i].second.first, h = hotSpots[i].second.second;
+            out << "[trace] hotspot g=" << g << " h=" << h << " slack=" << goalCost - g - h
+                << " expanded=" << cells[hotSpots[i].second] << "\n";
+        }
+    } else {
+        out << "[trace] goal_cost=none\n";
+    }
+
+    std::vector<std::pair<std::uint64_t, StateCounts>> repeated;
+    for (const auto& entry : states) {
+        if (entry.second.expanded > 1) repeated.emplace_back(entry.first, entry.second);
+    }
+    out << "[trace] transpositions distinct=" << states.size() << " expansions=" << events[static_cast<std::size_t>(TraceEvent::Expanded)]
+        << " repeated_in_pass=" << repeatedInPass << " states_repeated=" << repeated.size() << "\n";
+    const std::size_t shown = std::min(top, repeated.size());
+    std::partial_sort(repeated.begin(), repeated.begin() + static_cast<std::ptrdiff_t>(shown), repeated.end(),
+                      [](const std::pair<std::uint64_t, StateCounts>& a, const std::pair<std::uint64_t, StateCounts>& b) {
+                          if (a.second.expanded != b.second.expanded) return a.second.expanded > b.second.expanded;
+                          return a.first < b.first;
+                      });
+    for (std::size_t i = 0; i < shown; ++i) {
+        out << "[trace] transposition state=" << Hex(repeated[i].first)
+            << " expanded=" << repeated[i].second.expanded << " min_g=" << repeated[i].second.minG << "\n";
+    }
+}